@@ -56,56 +56,80 @@ account_t * account_t::find_account(const string& acct_name,
   if (i != accounts.end())
     return (*i).second;
 
-  char buf[8192];
-
   string::size_type sep = acct_name.find(':');
-  assert(sep < 256|| sep == string::npos);
-
-  const char * first, * rest;
-  if (sep == string::npos) {
-    first = acct_name.c_str();
-    rest  = NULL;
-  } else {
-    std::strncpy(buf, acct_name.c_str(), sep);
-    buf[sep] = '\0';
+  if (sep == string::npos)
+    return find_child_account(acct_name, auto_create);
+
+  if (accounts_by_path) {
+    accounts_path_map::const_iterator j = accounts_by_path->find(acct_name);
+    if (j != accounts_by_path->end())
+      return (*j).second;
+  }
+
+  // Walk down the path one segment at a time, reusing the same buffer for
+  // each segment's name.
+  account_t *       account = this;
+  string            segment;
+  string::size_type start   = 0;
+  while (true) {
+    segment.assign(acct_name, start,
+                   sep == string::npos ? string::npos : sep - start);
+    account = account->find_child_account(segment, auto_create);
+    if (! account)
+      return NULL;
 
-    first = buf;
-    rest  = acct_name.c_str() + sep + 1;
+    if (sep == string::npos)
+      break;
+    start = sep + 1;
+    sep   = acct_name.find(':', start);
   }
 
-  account_t * account;
+  if (! accounts_by_path)
+    accounts_by_path = accounts_path_map();
+  accounts_by_path->insert(accounts_path_map::value_type(acct_name, account));
 
-  i = accounts.find(first);
-  if (i == accounts.end()) {
-    if (! auto_create)
-      return NULL;
+  return account;
+}
 
-    account = new account_t(this, first);
+account_t * account_t::find_child_account(const string& name,
+                                          const bool    auto_create)
+{
+  accounts_map::const_iterator i = accounts.find(name);
+  if (i != accounts.end())
+    return (*i).second;
 
-    // An account created within a temporary or generated account is itself
-    // temporary or generated, so that the whole tree has the same status.
-    if (has_flags(ACCOUNT_TEMP))
-      account->add_flags(ACCOUNT_TEMP);
-    if (has_flags(ACCOUNT_GENERATED))
-      account->add_flags(ACCOUNT_GENERATED);
+  if (! auto_create)
+    return NULL;
+
+  account_t * account = new account_t(this, name);
+
+  // An account created within a temporary or generated account is itself
+  // temporary or generated, so that the whole tree has the same status.
+  if (has_flags(ACCOUNT_TEMP))
+    account->add_flags(ACCOUNT_TEMP);
+  if (has_flags(ACCOUNT_GENERATED))
+    account->add_flags(ACCOUNT_GENERATED);
 
 #if DEBUG_ON
-    std::pair<accounts_map::iterator, bool> result =
+  std::pair<accounts_map::iterator, bool> result =
 #endif
-      accounts.insert(accounts_map::value_type(first, account));
+    accounts.insert(accounts_map::value_type(name, account));
 #if DEBUG_ON
-    assert(result.second);
+  assert(result.second);
 #endif
-  } else {
-    account = (*i).second;
-  }
-
-  if (rest)
-    account = account->find_account(rest, auto_create);
 
   return account;
 }
 
+void account_t::clear_path_caches()
+{
+  // Only this account and its parents can have cached paths leading into a
+  // subtree which is being removed.
+  for (account_t * acct = this; acct; acct = acct->parent)
+    if (acct->accounts_by_path)
+      acct->accounts_by_path->clear();
+}
+
 namespace {
   account_t * find_account_re_(account_t * account, const mask_t& regexp)
   {
@@ -188,7 +212,7 @@ bool account_t::remove_post(post_t * post)
   // remove it anyway.  This can happen if there is an error during
   // parsing, when the posting knows what it's account is, but
   // xact_t::finalize has not yet added that posting to the account.
-  posts.remove(post);
+  posts.erase(std::remove(posts.begin(), posts.end(), post), posts.end());
   post->account = NULL;
   return true;
 }
@@ -615,21 +639,22 @@ value_t account_t::amount(const optional<bool> real_only, const optional<expr_t&
   DEBUG("account.amount", "real only: " << real_only);
 
   if (xdata_ && xdata_->has_flags(ACCOUNT_EXT_VISITED)) {
-    posts_list::const_iterator i;
+    std::size_t i;
     if (xdata_->self_details.last_post)
       i = *xdata_->self_details.last_post;
     else
-      i = posts.begin();
-
-    for (; i != posts.end(); i++) {
-      if ((*i)->xdata().has_flags(POST_EXT_VISITED)) {
-        if (! (*i)->xdata().has_flags(POST_EXT_CONSIDERED)) {
-          if (! (*i)->has_flags(POST_VIRTUAL)) {
-            (*i)->add_to_value(xdata_->self_details.real_total, expr);
+      i = 0;
+
+    for (; i < posts.size(); i++) {
+      post_t * post = posts[i];
+      if (post->xdata().has_flags(POST_EXT_VISITED)) {
+        if (! post->xdata().has_flags(POST_EXT_CONSIDERED)) {
+          if (! post->has_flags(POST_VIRTUAL)) {
+            post->add_to_value(xdata_->self_details.real_total, expr);
           }
 
-          (*i)->add_to_value(xdata_->self_details.total, expr);
-          (*i)->xdata().add_flags(POST_EXT_CONSIDERED);
+          post->add_to_value(xdata_->self_details.total, expr);
+          post->xdata().add_flags(POST_EXT_CONSIDERED);
         }
       }
       xdata_->self_details.last_post = i;
@@ -638,17 +663,18 @@ value_t account_t::amount(const optional<bool> real_only, const optional<expr_t&
     if (xdata_->self_details.last_reported_post)
       i = *xdata_->self_details.last_reported_post;
     else
-      i = xdata_->reported_posts.begin();
-
-    for (; i != xdata_->reported_posts.end(); i++) {
-      if ((*i)->xdata().has_flags(POST_EXT_VISITED)) {
-        if (! (*i)->xdata().has_flags(POST_EXT_CONSIDERED)) {
-          if (! (*i)->has_flags(POST_VIRTUAL)) {
-            (*i)->add_to_value(xdata_->self_details.real_total, expr);
+      i = 0;
+
+    for (; i < xdata_->reported_posts.size(); i++) {
+      post_t * post = xdata_->reported_posts[i];
+      if (post->xdata().has_flags(POST_EXT_VISITED)) {
+        if (! post->xdata().has_flags(POST_EXT_CONSIDERED)) {
+          if (! post->has_flags(POST_VIRTUAL)) {
+            post->add_to_value(xdata_->self_details.real_total, expr);
           }
 
-          (*i)->add_to_value(xdata_->self_details.total, expr);
-          (*i)->xdata().add_flags(POST_EXT_CONSIDERED);
+          post->add_to_value(xdata_->self_details.total, expr);
+          post->xdata().add_flags(POST_EXT_CONSIDERED);
         }
       }
       xdata_->self_details.last_reported_post = i;
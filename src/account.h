@@ -50,8 +50,9 @@ class account_t;
 class xact_t;
 class post_t;
 
-typedef std::list<post_t *> posts_list;
+typedef std::vector<post_t *> posts_list;
 typedef std::map<string, account_t *> accounts_map;
+typedef std::unordered_map<string, account_t *> accounts_path_map;
 typedef std::map<string, posts_list> deferred_posts_map_t;
 
 class account_t : public supports_flags<>, public scope_t
@@ -71,6 +72,22 @@ public:
   optional<deferred_posts_map_t> deferred_posts;
   optional<expr_t>               value_expr;
 
+  // Descendants already found by a lookup of a full "A:B:C" path relative
+  // to this account, so that repeated lookups from the journal's master
+  // account need not walk the tree one level at a time.
+  optional<accounts_path_map>    accounts_by_path;
+
+  // The totals of this account's own postings up to the end of each day
+  // on which it has any, for balance reports that need nothing else.
+  // See journal_t::build_running_totals.
+  struct running_total_t {
+    date_t      date;
+    std::size_t count;
+    value_t     total;
+    value_t     real_total;
+  };
+  std::vector<running_total_t>   running_totals;
+
   mutable string   _fullname;
 #if DOCUMENT_MODEL
   mutable void * data;
@@ -118,10 +135,14 @@ public:
   }
   bool remove_account(account_t * acct) {
     accounts_map::size_type n = accounts.erase(acct->name);
+    if (n > 0)
+      clear_path_caches();
     return n > 0;
   }
 
   account_t * find_account(const string& name, bool auto_create = true);
+  account_t * find_child_account(const string& name, bool auto_create = true);
+  void        clear_path_caches();
   account_t * find_account_re(const string& regexp);
 
   typedef transform_iterator<function<account_t *(accounts_map::value_type&)>,
@@ -194,8 +215,11 @@ public:
       std::set<string>   accounts_referenced;
       std::set<string>   payees_referenced;
 
-      optional<posts_list::const_iterator> last_post;
-      optional<posts_list::const_iterator> last_reported_post;
+      // How far into posts and reported_posts amount() has summed.
+      // Postings may be appended in between, which would invalidate an
+      // iterator into a vector, so these are indexes.
+      optional<std::size_t> last_post;
+      optional<std::size_t> last_reported_post;
 
       details_t()
         : calculated(false),
@@ -36,30 +36,66 @@
 #include "commodity.h"
 #include "annotate.h"
 #include "pool.h"
+#include "pstream.h"
 
 namespace ledger {
 
 bool amount_t::stream_fullstrings = false;
 
-#if !defined(THREADSAFE)
-// These global temporaries are pre-initialized for the sake of
-// efficiency, and are reused over and over again.
-static mpz_t  temp;
-static mpq_t  tempq;
-static mpfr_t tempf;
-static mpfr_t tempfb;
-static mpfr_t tempfnum;
-static mpfr_t tempfden;
-#endif
+namespace {
+  // These temporaries are pre-initialized for the sake of efficiency,
+  // and are reused over and over again.  Each thread gets its own set
+  // when it first needs one.
+  struct scratch_t
+  {
+    mpz_t  temp;
+    mpz_t  tempscale;
+    mpz_t  temprem;
+    mpq_t  tempq;
+    mpfr_t tempf;
+    mpfr_t tempfb;
+    mpfr_t tempfnum;
+    mpfr_t tempfden;
+
+    scratch_t() {
+      mpz_init(temp);
+      mpz_init(tempscale);
+      mpz_init(temprem);
+      mpq_init(tempq);
+      mpfr_init(tempf);
+      mpfr_init(tempfb);
+      mpfr_init(tempfnum);
+      mpfr_init(tempfden);
+    }
+    ~scratch_t() {
+      mpz_clear(temp);
+      mpz_clear(tempscale);
+      mpz_clear(temprem);
+      mpq_clear(tempq);
+      mpfr_clear(tempf);
+      mpfr_clear(tempfb);
+      mpfr_clear(tempfnum);
+      mpfr_clear(tempfden);
+    }
+  };
+
+  scratch_t& scratch()
+  {
+    static thread_local scratch_t temps;
+    return temps;
+  }
+}
 
 struct amount_t::bigint_t : public supports_flags<>
 {
 #define BIGINT_BULK_ALLOC 0x01
 #define BIGINT_KEEP_PREC  0x02
 
-  mpq_t          val;
-  precision_t    prec;
-  uint_least32_t refc;
+  // Amounts share their quantity until one of them changes it, and the
+  // sharers may live on different threads, so the count is atomic.
+  mpq_t                       val;
+  precision_t                 prec;
+  std::atomic<uint_least32_t> refc;
 
 #define MP(bigint) ((bigint)->val)
 
@@ -98,6 +134,73 @@ struct amount_t::bigint_t : public supports_flags<>
 bool amount_t::is_initialized = false;
 
 namespace {
+  // Render a rational whose denominator has no prime factors other than
+  // 2 and 5 -- which covers every amount that was parsed from decimal
+  // text -- directly from its digits, producing exactly what mpfr's
+  // "%.*RNf" would.  Returns false for true fractions, and for values
+  // lying exactly halfway between two representable results, whose
+  // rounding is left to mpfr so that the output never changes.
+  bool stream_out_decimal(string&               str,
+                          mpq_t                 quant,
+                          amount_t::precision_t precision)
+  {
+    if (! mpz_fits_ulong_p(mpq_denref(quant)))
+      return false;
+
+    unsigned long den   = mpz_get_ui(mpq_denref(quant));
+    unsigned int  twos  = 0;
+    unsigned int  fives = 0;
+    while (den % 2 == 0) {
+      den /= 2;
+      ++twos;
+    }
+    while (den % 5 == 0) {
+      den /= 5;
+      ++fives;
+    }
+    if (den != 1)
+      return false;
+
+    scratch_t& temps(scratch());
+    mpz_ptr    temp      = temps.temp;
+    mpz_ptr    tempscale = temps.tempscale;
+    mpz_ptr    temprem   = temps.temprem;
+
+    // Scale the numerator so that the value is temp / 10^places.
+    unsigned int places = std::max(twos, fives);
+    mpz_abs(temp, mpq_numref(quant));
+    if (twos < places)
+      mpz_mul_2exp(temp, temp, places - twos);
+    for (unsigned int i = fives; i < places; i++)
+      mpz_mul_ui(temp, temp, 5);
+
+    if (places > precision) {
+      mpz_ui_pow_ui(tempscale, 10, places - precision);
+      mpz_tdiv_qr(temp, temprem, temp, tempscale);
+      mpz_mul_2exp(temprem, temprem, 1);
+      int half = mpz_cmp(temprem, tempscale);
+      if (half == 0)
+        return false;
+      else if (half > 0)
+        mpz_add_ui(temp, temp, 1);
+      places = precision;
+    }
+
+    str.assign(mpz_sizeinbase(temp, 10) + 2, '\0');
+    mpz_get_str(&str[0], 10, temp);
+    str.resize(std::strlen(str.c_str()));
+
+    if (str.length() <= places)
+      str.insert(0, places + 1 - str.length(), '0');
+    if (precision > 0) {
+      str.insert(str.length() - places, 1, '.');
+      str.append(precision - places, '0');
+    }
+    if (mpz_sgn(mpq_numref(quant)) < 0)
+      str.insert(0, 1, '-');
+    return true;
+  }
+
   void stream_out_mpq(std::ostream&                 out,
                       mpq_t                         quant,
                       amount_t::precision_t         precision,
@@ -105,6 +208,7 @@ namespace {
                       mpfr_rnd_t                    rnd        = GMP_RNDN,
                       const optional<commodity_t&>& comm       = none)
   {
+    string fixed;
     char * buf = NULL;
     try {
 #if DEBUG_ON
@@ -115,64 +219,93 @@ namespace {
       }
 #endif
 
-      // Convert the rational number to a floating-point, extending the
-      // floating-point to a large enough size to get a precise answer.
-
-      mp_prec_t num_prec =
-        static_cast<mpfr_prec_t>(mpz_sizeinbase(mpq_numref(quant), 2));
-      num_prec += amount_t::extend_by_digits*64;
-      if (num_prec < MPFR_PREC_MIN)
-        num_prec = MPFR_PREC_MIN;
-      DEBUG("amount.convert", "num prec = " << num_prec);
-
-      mpfr_set_prec(tempfnum, num_prec);
-      mpfr_set_z(tempfnum, mpq_numref(quant), rnd);
-
-      mp_prec_t den_prec =
-        static_cast<mpfr_prec_t>(mpz_sizeinbase(mpq_denref(quant), 2));
-      den_prec += amount_t::extend_by_digits*64;
-      if (den_prec < MPFR_PREC_MIN)
-        den_prec = MPFR_PREC_MIN;
-      DEBUG("amount.convert", "den prec = " << den_prec);
-
-      mpfr_set_prec(tempfden, den_prec);
-      mpfr_set_z(tempfden, mpq_denref(quant), rnd);
-
-      mpfr_set_prec(tempfb, num_prec + den_prec);
-      mpfr_div(tempfb, tempfnum, tempfden, rnd);
-
-      if (mpfr_asprintf(&buf, "%.*RNf", precision, tempfb) < 0)
-        throw_(amount_error,
-               _("Cannot output amount to a floating-point representation"));
-
-      DEBUG("amount.convert", "mpfr_print = " << buf
-            << " (precision " << precision
-            << ", zeros_prec " << zeros_prec << ")");
+      char * str;
+      if (stream_out_decimal(fixed, quant, precision)) {
+        str = &fixed[0];
+        DEBUG("amount.convert", "decimal = " << str
+              << " (precision " << precision
+              << ", zeros_prec " << zeros_prec << ")");
+      } else {
+        // Convert the rational number to a floating-point, extending
+        // the floating-point to a large enough size to get a precise
+        // answer.
+        scratch_t& temps(scratch());
+        mpfr_ptr   tempfb   = temps.tempfb;
+        mpfr_ptr   tempfnum = temps.tempfnum;
+        mpfr_ptr   tempfden = temps.tempfden;
+
+        mp_prec_t num_prec =
+          static_cast<mpfr_prec_t>(mpz_sizeinbase(mpq_numref(quant), 2));
+        num_prec += amount_t::extend_by_digits*64;
+        if (num_prec < MPFR_PREC_MIN)
+          num_prec = MPFR_PREC_MIN;
+        DEBUG("amount.convert", "num prec = " << num_prec);
+
+        mpfr_set_prec(tempfnum, num_prec);
+        mpfr_set_z(tempfnum, mpq_numref(quant), rnd);
+
+        mp_prec_t den_prec =
+          static_cast<mpfr_prec_t>(mpz_sizeinbase(mpq_denref(quant), 2));
+        den_prec += amount_t::extend_by_digits*64;
+        if (den_prec < MPFR_PREC_MIN)
+          den_prec = MPFR_PREC_MIN;
+        DEBUG("amount.convert", "den prec = " << den_prec);
+
+        mpfr_set_prec(tempfden, den_prec);
+        mpfr_set_z(tempfden, mpq_denref(quant), rnd);
+
+        mpfr_set_prec(tempfb, num_prec + den_prec);
+        mpfr_div(tempfb, tempfnum, tempfden, rnd);
+
+        if (mpfr_asprintf(&buf, "%.*RNf", precision, tempfb) < 0)
+          throw_(amount_error,
+                 _("Cannot output amount to a floating-point representation"));
+        str = buf;
+
+        DEBUG("amount.convert", "mpfr_print = " << buf
+              << " (precision " << precision
+              << ", zeros_prec " << zeros_prec << ")");
+      }
 
       if (zeros_prec >= 0) {
-        string::size_type index = std::strlen(buf);
+        string::size_type index = std::strlen(str);
         string::size_type point = 0;
         for (string::size_type i = 0; i < index; i++) {
-          if (buf[i] == '.') {
+          if (str[i] == '.') {
             point = i;
             break;
           }
         }
         if (point > 0) {
           while (--index >= (point + 1 + static_cast<std::size_t>(zeros_prec)) &&
-                 buf[index] == '0')
-            buf[index] = '\0';
+                 str[index] == '0')
+            str[index] = '\0';
           if (index >= (point + static_cast<std::size_t>(zeros_prec)) &&
-              buf[index] == '.')
-            buf[index] = '\0';
+              str[index] == '.')
+            str[index] = '\0';
         }
       }
 
       if (comm) {
+        // Decide on the separators once, rather than for every digit.
+        char decimal_mark   = '.';
+        char thousands_mark = ',';
+        if ((commodity_t::time_colon_by_default ||
+             comm->has_flags(COMMODITY_STYLE_TIME_COLON)) &&
+            ("h" == comm->symbol() || "m" == comm->symbol())) {
+          decimal_mark   = ':';
+          thousands_mark = ':';
+        }
+        else if (commodity_t::decimal_comma_by_default ||
+                 comm->has_flags(COMMODITY_STYLE_DECIMAL_COMMA)) {
+          decimal_mark   = ',';
+          thousands_mark = '.';
+        }
+
         int integer_digits = 0;
-        if (comm && comm->has_flags(COMMODITY_STYLE_THOUSANDS)) {
+        if (comm->has_flags(COMMODITY_STYLE_THOUSANDS)) {
           // Count the number of integer digits
-          for (const char * p = buf; *p; p++) {
+          for (const char * p = str; *p; p++) {
             if (*p == '.')
               break;
             else if (*p != '-')
@@ -180,38 +313,26 @@ namespace {
           }
         }
 
-        for (const char * p = buf; *p; p++) {
+        string result;
+        result.reserve(std::strlen(str) + integer_digits / 3);
+        for (const char * p = str; *p; p++) {
           if (*p == '.') {
-            if (("h" == comm->symbol() || "m" == comm->symbol()) && (commodity_t::time_colon_by_default ||
-                (comm && comm->has_flags(COMMODITY_STYLE_TIME_COLON))))
-              out << ':';
-            else if (commodity_t::decimal_comma_by_default ||
-                (comm && comm->has_flags(COMMODITY_STYLE_DECIMAL_COMMA)))
-              out << ',';
-            else
-              out << *p;
+            result += decimal_mark;
             assert(integer_digits <= 3);
           }
           else if (*p == '-') {
-            out << *p;
+            result += *p;
           }
           else {
-            out << *p;
-
-            if (integer_digits > 3 && --integer_digits % 3 == 0) {
-              if (("h" == comm->symbol() || "m" == comm->symbol()) && (commodity_t::time_colon_by_default ||
-                  (comm && comm->has_flags(COMMODITY_STYLE_TIME_COLON))))
-                out << ':';
-              else if (commodity_t::decimal_comma_by_default ||
-                  (comm && comm->has_flags(COMMODITY_STYLE_DECIMAL_COMMA)))
-                out << '.';
-              else
-                out << ',';
-            }
+            result += *p;
+
+            if (integer_digits > 3 && --integer_digits % 3 == 0)
+              result += thousands_mark;
           }
         }
+        out << result;
       } else {
-        out << buf;
+        out << str;
       }
     }
     catch (...) {
@@ -227,13 +348,6 @@ namespace {
 void amount_t::initialize()
 {
   if (! is_initialized) {
-    mpz_init(temp);
-    mpq_init(tempq);
-    mpfr_init(tempf);
-    mpfr_init(tempfb);
-    mpfr_init(tempfnum);
-    mpfr_init(tempfden);
-
     commodity_pool_t::current_pool.reset(new commodity_pool_t);
 
     // Add time commodity conversions, so that timelogs may be parsed
@@ -260,13 +374,6 @@ void amount_t::initialize()
 void amount_t::shutdown()
 {
   if (is_initialized) {
-    mpz_clear(temp);
-    mpq_clear(tempq);
-    mpfr_clear(tempf);
-    mpfr_clear(tempfb);
-    mpfr_clear(tempfnum);
-    mpfr_clear(tempfden);
-
     commodity_pool_t::current_pool.reset();
 
     is_initialized = false;
@@ -363,6 +470,17 @@ amount_t::amount_t(const long val) : commodity_(NULL)
 }
 
 
+amount_t amount_t::scaled(const long value, const precision_t places)
+{
+  amount_t temp(value);
+  if (places > 0) {
+    mpz_ui_pow_ui(mpq_denref(MP(temp.quantity)), 10, places);
+    mpq_canonicalize(MP(temp.quantity));
+  }
+  temp.quantity->prec = places;
+  return temp;
+}
+
 amount_t& amount_t::operator=(const amount_t& amt)
 {
   if (this != &amt) {
@@ -646,9 +764,10 @@ void amount_t::in_place_truncate()
 
   mpq_set_str(MP(quantity), buf.get(), 10);
 
-  mpz_ui_pow_ui(temp, 10, display_precision());
-  mpq_set_z(tempq, temp);
-  mpq_div(MP(quantity), MP(quantity), tempq);
+  scratch_t& temps(scratch());
+  mpz_ui_pow_ui(temps.temp, 10, display_precision());
+  mpq_set_z(temps.tempq, temps.temp);
+  mpq_div(MP(quantity), MP(quantity), temps.tempq);
 
   DEBUG("amount.truncate", "Truncated = " << *this);
 #else
@@ -665,6 +784,7 @@ void amount_t::in_place_floor()
 
   _dup();
 
+  mpz_ptr temp = scratch().temp;
   mpz_fdiv_q(temp,  mpq_numref(MP(quantity)), mpq_denref(MP(quantity)));
   mpq_set_z(MP(quantity), temp);
 }
@@ -676,6 +796,7 @@ void amount_t::in_place_ceiling()
 
   _dup();
 
+  mpz_ptr temp = scratch().temp;
   mpz_cdiv_q(temp,  mpq_numref(MP(quantity)), mpq_denref(MP(quantity)));
   mpq_set_z(MP(quantity), temp);
 }
@@ -868,6 +989,7 @@ double amount_t::to_double() const
   if (! quantity)
     throw_(amount_error, _("Cannot convert an uninitialized amount to a double"));
 
+  mpfr_ptr tempf = scratch().tempf;
   mpfr_set_q(tempf, MP(quantity), GMP_RNDN);
   return mpfr_get_d(tempf, GMP_RNDN);
 }
@@ -877,16 +999,37 @@ long amount_t::to_long() const
   if (! quantity)
     throw_(amount_error, _("Cannot convert an uninitialized amount to a long"));
 
+  mpfr_ptr tempf = scratch().tempf;
   mpfr_set_q(tempf, MP(quantity), GMP_RNDN);
   return mpfr_get_si(tempf, GMP_RNDN);
 }
 
 bool amount_t::fits_in_long() const
 {
+  mpfr_ptr tempf = scratch().tempf;
   mpfr_set_q(tempf, MP(quantity), GMP_RNDN);
   return mpfr_fits_slong_p(tempf, GMP_RNDN);
 }
 
+bool amount_t::to_scaled_long(const precision_t places, long& result) const
+{
+  if (! quantity)
+    throw_(amount_error, _("Cannot convert an uninitialized amount to a long"));
+
+  scratch_t& temps(scratch());
+  mpz_ui_pow_ui(temps.tempscale, 10, places);
+  mpz_mul(temps.temp, mpq_numref(MP(quantity)), temps.tempscale);
+
+  if (! mpz_divisible_p(temps.temp, mpq_denref(MP(quantity))))
+    return false;
+  mpz_divexact(temps.temp, temps.temp, mpq_denref(MP(quantity)));
+
+  if (! mpz_fits_slong_p(temps.temp))
+    return false;
+  result = mpz_get_si(temps.temp);
+  return true;
+}
+
 commodity_t * amount_t::commodity_ptr() const
 {
   return (commodity_ ?
@@ -1048,6 +1191,19 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
       throw_(amount_error, _("No quantity specified for amount"));
   }
 
+  finish_parse(quant.c_str(), quant.length(), symbol, details, negative,
+               comm_flags, flags);
+  return true;
+}
+
+void amount_t::finish_parse(const char *          quant,
+                            std::size_t           quant_len,
+                            const string&         symbol,
+                            annotation_t&         details,
+                            bool                  negative,
+                            uint_least16_t        comm_flags,
+                            const parse_flags_t&  flags)
+{
   // Allocate memory for the amount's quantity value.  We have to
   // monitor the allocation in a unique_ptr because this function gets
   // called sometimes from amount_t's constructor; and if there is an
@@ -1076,9 +1232,7 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
   if (symbol.empty()) {
     commodity_ = NULL;
   } else {
-    commodity_ = commodity_pool_t::current_pool->find(symbol);
-    if (! commodity_)
-      commodity_ = commodity_pool_t::current_pool->create(symbol);
+    commodity_ = commodity_pool_t::current_pool->find_or_create(symbol);
     assert(commodity_);
   }
 
@@ -1086,7 +1240,7 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
   // punctuation.
 
   precision_t       decimal_offset  = 0;
-  string::size_type string_index    = quant.length();
+  string::size_type string_index    = quant_len;
   string::size_type last_comma      = string::npos;
   string::size_type last_period     = string::npos;
 
@@ -1105,7 +1259,8 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
 
   new_quantity->prec = 0;
 
-  BOOST_REVERSE_FOREACH (const char& ch, quant) {
+  for (const char * q = quant + quant_len; q != quant; ) {
+    const char ch = *--q;
     string_index--;
 
     if (ch == '.') {
@@ -1178,21 +1333,54 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
     new_quantity->add_flags(BIGINT_KEEP_PREC);
   }
   else if (commodity_ && ! no_migrate_style) {
-    commodity().add_flags(comm_flags);
+    // Once a commodity's style is learned, parsing it again leaves the
+    // commodity untouched, so that other threads may read it freely.
+    if ((commodity().flags() & comm_flags) != comm_flags)
+      commodity().add_flags(comm_flags);
 
     if (new_quantity->prec > commodity().precision())
       commodity().set_precision(new_quantity->prec);
   }
 
-  // Now we have the final number.  Remove commas and periods, if necessary.
+  // Now we have the final number.  If its digits fit in an unsigned long,
+  // convert them directly, skipping the commas and periods.
+
+  unsigned long value  = 0;
+  std::size_t   digits = 0;
+  bool          direct = true;
+
+  for (const char * q = quant; q != quant + quant_len; q++) {
+    if (std::isdigit(static_cast<unsigned char>(*q))) {
+      if (++digits > static_cast<std::size_t>
+          (std::numeric_limits<unsigned long>::digits10)) {
+        direct = false;
+        break;
+      }
+      value = value * 10 + static_cast<unsigned long>(*q - '0');
+    }
+    else if (*q != ',' && *q != '.') {
+      direct = false;
+      break;
+    }
+  }
+
+  if (direct) {
+    // The precision never exceeds the number of digits, so this fits too.
+    unsigned long scale = 1;
+    for (precision_t i = 0; i < new_quantity->prec; i++)
+      scale *= 10;
 
-  if (last_comma != string::npos || last_period != string::npos) {
-    string::size_type  len = quant.length();
-    scoped_array<char> buf(new char[len + 1]);
-    const char *       p   = quant.c_str();
+    mpq_set_ui(MP(new_quantity.get()), value, scale);
+    mpq_canonicalize(MP(new_quantity.get()));
+  }
+  else if (last_comma != string::npos || last_period != string::npos) {
+    // Otherwise remove the commas and periods, if necessary.
+    scoped_array<char> buf(new char[quant_len + 1]);
+    const char *       p   = quant;
+    const char *       end = quant + quant_len;
     char *             t   = buf.get();
 
-    while (*p) {
+    while (p != end) {
       if (*p == ',' || *p == '.')
         p++;
       *t++ = *p++;
@@ -1200,9 +1388,11 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
     *t = '\0';
 
     mpq_set_str(MP(new_quantity.get()), buf.get(), 10);
-    mpz_ui_pow_ui(temp, 10, new_quantity->prec);
-    mpq_set_z(tempq, temp);
-    mpq_div(MP(new_quantity.get()), MP(new_quantity.get()), tempq);
+
+    scratch_t& temps(scratch());
+    mpz_ui_pow_ui(temps.temp, 10, new_quantity->prec);
+    mpq_set_z(temps.tempq, temps.temp);
+    mpq_div(MP(new_quantity.get()), MP(new_quantity.get()), temps.tempq);
 
     IF_DEBUG("amount.parse") {
       char * amt_buf = mpq_get_str(NULL, 10, MP(new_quantity.get()));
@@ -1210,7 +1400,7 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
       std::free(amt_buf);
     }
   } else {
-    mpq_set_str(MP(new_quantity.get()), quant.c_str(), 10);
+    mpq_set_str(MP(new_quantity.get()), string(quant, quant_len).c_str(), 10);
   }
 
   if (negative)
@@ -1231,7 +1421,117 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
   }
 
   VERIFY(valid());
+}
+
+namespace {
+  const char * skip_spaces(const char * p)
+  {
+    while (std::isspace(static_cast<unsigned char>(*p)))
+      p++;
+    return p;
+  }
+
+  // Return the end of the quantity at P, as parse_quantity would read it.
+  const char * scan_quantity(const char * p)
+  {
+    const char * b = skip_spaces(p);
+    const char * e = b;
+    while (e - b < 255 &&
+           (std::isdigit(static_cast<unsigned char>(*e)) ||
+            *e == '-' || *e == '.' || *e == ','))
+      e++;
+    while (e > b && ! std::isdigit(static_cast<unsigned char>(*(e - 1))))
+      e--;
+    return e;
+  }
+
+  // True if annotation_t::parse would find an annotation at P.
+  bool annotation_follows(const char * p)
+  {
+    p = skip_spaces(p);
+    return *p == '{' || *p == '[' || (*p == '(' && *(p + 1) != '@');
+  }
+
+  bool parse_from_stream(amount_t& amount, const char *& in,
+                         const parse_flags_t& flags)
+  {
+    ptristream stream(const_cast<char *>(in));
+    bool result = amount.parse(stream, flags);
+    if (stream.eof())
+      in += std::strlen(in);
+    else
+      in += static_cast<std::ptrdiff_t>(stream.tellg());
+    return result;
+  }
+}
+
+bool amount_t::parse(const char *& in, const parse_flags_t& flags)
+{
+  // This follows the syntax, and the reading of the stream, of the
+  // parse(std::istream&) above; anything it does not handle goes there.
+
+  string         symbol;
+  const char *   quant      = NULL;
+  std::size_t    quant_len  = 0;
+  annotation_t   details;
+  bool           negative   = false;
+  uint_least16_t comm_flags = COMMODITY_STYLE_DEFAULTS;
+
+  const char * p = skip_spaces(in);
+  if (*p == '-') {
+    negative = true;
+    p = skip_spaces(p + 1);
+  }
+
+  if (std::isdigit(static_cast<unsigned char>(*p))) {
+    quant     = p;
+    p         = scan_quantity(p);
+    quant_len = static_cast<std::size_t>(p - quant);
+
+    if (*p && *p != '\n') {
+      if (std::isspace(static_cast<unsigned char>(*p)))
+        comm_flags |= COMMODITY_STYLE_SEPARATED;
+
+      if (! commodity_t::parse_symbol(p, symbol))
+        return parse_from_stream(*this, in, flags);
+
+      if (! symbol.empty())
+        comm_flags |= COMMODITY_STYLE_SUFFIXED;
+
+      if (! flags.has_flags(PARSE_NO_ANNOT) &&
+          *p && *p != '\n' && annotation_follows(p))
+        return parse_from_stream(*this, in, flags);
+    }
+  } else {
+    if (! commodity_t::parse_symbol(p, symbol))
+      return parse_from_stream(*this, in, flags);
+
+    if (*p && *p != '\n') {
+      if (std::isspace(static_cast<unsigned char>(*p)))
+        comm_flags |= COMMODITY_STYLE_SEPARATED;
+
+      const char * e = scan_quantity(p);
+      quant     = skip_spaces(p);
+      quant_len = static_cast<std::size_t>(e > quant ? e - quant : 0);
+      p         = e > quant ? e : quant;
+
+      if (! flags.has_flags(PARSE_NO_ANNOT) && quant_len > 0 &&
+          *p && *p != '\n' && annotation_follows(p))
+        return parse_from_stream(*this, in, flags);
+    }
+  }
+
+  if (quant_len == 0) {
+    if (flags.has_flags(PARSE_SOFT_FAIL))
+      return false;
+    else
+      throw_(amount_error, _("No quantity specified for amount"));
+  }
+
+  finish_parse(quant, quant_len, symbol, details, negative, comm_flags,
+               flags);
 
+  in = p;
   return true;
 }
 
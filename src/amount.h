@@ -123,6 +123,16 @@ protected:
   void _clear();
   void _release();
 
+  // The second half of parsing, shared by both parse() methods: set this
+  // amount from the QUANT digits and commodity SYMBOL read by the first.
+  void finish_parse(const char *          quant,
+                    std::size_t           quant_len,
+                    const string&         symbol,
+                    annotation_t&         details,
+                    bool                  negative,
+                    uint_least16_t        comm_flags,
+                    const parse_flags_t&  flags);
+
   struct bigint_t;
 
   bigint_t *    quantity;
@@ -179,6 +189,11 @@ public:
       $100.01, even though its internal value equals \c $100.005. */
   static amount_t exact(const string& value);
 
+  /** Create an uncommoditized amount equal to `value / 10^places', kept
+      at a precision of \c places.  This is the inverse of
+      to_scaled_long(), for code that sums decimal amounts as integers. */
+  static amount_t scaled(const long value, const precision_t places);
+
   /** Release the reference count held for the underlying \c
       amount_t::bigint_t object. */
   ~amount_t() {
@@ -499,6 +514,10 @@ public:
       fits_in_long() returns true if to_long() would not lose
       precision.
 
+      to_scaled_long(places, result) sets result to the amount times
+      10^places and returns true, if that is a whole number which fits
+      in a long; otherwise it returns false.
+
       to_string() returns an amount'ss "display value" as a string --
       after rounding the value according to the commodity's default
       precision.  It is equivalent to: `round().to_fullstring()'.
@@ -515,6 +534,7 @@ public:
   double to_double() const;
   long   to_long() const;
   bool   fits_in_long() const;
+  bool   to_scaled_long(const precision_t places, long& result) const;
 
   operator string() const {
     return to_string();
@@ -677,9 +697,17 @@ public:
       parse(string, flags_t) parses an amount from the given string.
 
       parse(string, flags_t) also parses an amount from a string.
+
+      parse(const char *&, flags_t) parses an amount directly from a
+      character buffer, such as a journal line, without going through a
+      stream, and leaves the pointer just after the amount.  Amounts with
+      annotations, or with quoted or escaped commodity symbols, are
+      handed on to the stream parser.
   */
   bool parse(std::istream& in,
              const parse_flags_t& flags = PARSE_DEFAULT);
+  bool parse(const char *& in,
+             const parse_flags_t& flags = PARSE_DEFAULT);
   bool parse(const string& str,
              const parse_flags_t& flags = PARSE_DEFAULT) {
     std::istringstream stream(str);
@@ -231,17 +231,6 @@ void put_annotation(property_tree::ptree& st, const annotation_t& details)
     st.put("value_expr", details.value_expr->text());
 }
 
-bool keep_details_t::keep_all(const commodity_t& comm) const
-{
-  return (! comm.has_annotation() ||
-          (keep_price && keep_date && keep_tag && ! only_actuals));
-}
-
-bool keep_details_t::keep_any(const commodity_t& comm) const
-{
-  return comm.has_annotation() && (keep_price || keep_date || keep_tag);
-}
-
 bool annotated_commodity_t::operator==(const commodity_t& comm) const
 {
   // If the base commodities don't match, the game's up.
@@ -306,6 +295,12 @@ annotated_commodity_t::find_price(const commodity_t * commodity,
   return commodity_t::find_price(target, when, oldest);
 }
 
+namespace {
+  // Serializes filling and resetting the strip caches of all annotated
+  // commodities; misses are rare enough that one lock suffices.
+  std::mutex strip_mutex;
+}
+
 commodity_t&
 annotated_commodity_t::strip_annotations(const keep_details_t& what_to_keep)
 {
@@ -315,7 +310,16 @@ annotated_commodity_t::strip_annotations(const keep_details_t& what_to_keep)
          << "  keep date "  << what_to_keep.keep_date << " "
          << "  keep tag "   << what_to_keep.keep_tag);
 
-  commodity_t * new_comm;
+  // The annotation flags and these two commodity flags do not overlap.
+  const uint_least16_t current_flags =
+    ((flags() & (COMMODITY_SAW_ANN_PRICE_FLOAT |
+                 COMMODITY_SAW_ANN_PRICE_FIXATED)) | details.flags());
+
+  std::atomic<commodity_t *>& cached(stripped[what_to_keep.index()]);
+  if (stripped_flags.load(std::memory_order_acquire) == current_flags) {
+    if (commodity_t * comm = cached.load(std::memory_order_acquire))
+      return *comm;
+  }
 
   bool keep_price =
     ((what_to_keep.keep_price ||
@@ -339,6 +343,7 @@ annotated_commodity_t::strip_annotations(const keep_details_t& what_to_keep)
          << "  keep date "  << keep_date << " "
          << "  keep tag "   << keep_tag);
 
+  commodity_t * new_comm;
   if ((keep_price && details.price) ||
       (keep_date  && details.date)  ||
       (keep_tag   && details.tag)) {
@@ -359,11 +364,20 @@ annotated_commodity_t::strip_annotations(const keep_details_t& what_to_keep)
       if (keep_tag)
         new_details.add_flags(details.flags() & ANNOTATION_TAG_CALCULATED);
     }
-
-    return *new_comm;
+  } else {
+    new_comm = &referent();
   }
 
-  return referent();
+  {
+    std::lock_guard<std::mutex> guard(strip_mutex);
+    if (stripped_flags.load(std::memory_order_relaxed) != current_flags) {
+      for (std::size_t i = 0; i < KEEP_DETAILS_COMBINATIONS; i++)
+        stripped[i].store(NULL, std::memory_order_relaxed);
+      stripped_flags.store(current_flags, std::memory_order_release);
+    }
+    cached.store(new_comm, std::memory_order_release);
+  }
+  return *new_comm;
 }
 
 void annotated_commodity_t::write_annotations
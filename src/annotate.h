@@ -141,14 +141,27 @@ struct keep_details_t
   bool keep_all() const {
     return keep_price && keep_date && keep_tag && ! only_actuals;
   }
-  bool keep_all(const commodity_t& comm) const;
+  bool keep_all(const commodity_t& comm) const {
+    return ! comm.has_annotation() || keep_all();
+  }
 
   bool keep_any() const {
     return keep_price || keep_date || keep_tag;
   }
-  bool keep_any(const commodity_t& comm) const;
+  bool keep_any(const commodity_t& comm) const {
+    return comm.has_annotation() && keep_any();
+  }
+
+  // Each combination of the flags above has its own index, below
+  // KEEP_DETAILS_COMBINATIONS.
+  std::size_t index() const {
+    return ((keep_price   ? 0x1 : 0) | (keep_date ? 0x2 : 0) |
+            (keep_tag     ? 0x4 : 0) | (only_actuals ? 0x8 : 0));
+  }
 };
 
+#define KEEP_DETAILS_COMBINATIONS 16
+
 inline std::ostream& operator<<(std::ostream&       out,
                                 const annotation_t& details) {
   details.print(out);
@@ -166,9 +179,18 @@ protected:
 
   commodity_t * ptr;
 
+  // What strip_annotations returns depends only on what is kept, on the
+  // flags of these details, and on whether the base commodity has seen
+  // both floating and fixated lot prices.  Each result is remembered
+  // under keep_details_t::index() until any of those flags change.  The
+  // cache is read without locking; it is filled under a lock.
+  std::atomic<commodity_t *>  stripped[KEEP_DETAILS_COMBINATIONS];
+  std::atomic<uint_least16_t> stripped_flags;
+
   explicit annotated_commodity_t(commodity_t * _ptr,
                                  const annotation_t& _details)
-    : commodity_t(_ptr->parent_, _ptr->base), ptr(_ptr), details(_details) {
+    : commodity_t(_ptr->parent_, _ptr->base), ptr(_ptr), stripped(),
+      stripped_flags(0), details(_details) {
     annotated = true;
     qualified_symbol = _ptr->qualified_symbol;
     TRACE_CTOR(annotated_commodity_t, "commodity_t *, annotation_t");
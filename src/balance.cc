@@ -32,6 +32,7 @@
 #include <system.hh>
 
 #include "balance.h"
+#include "inventory.h"
 #include "commodity.h"
 #include "annotate.h"
 #include "pool.h"
@@ -76,9 +77,9 @@ balance_t& balance_t::operator+=(const amount_t& amt)
   if (amt.is_realzero())
     return *this;
 
-  amounts_map::iterator i =
-    amt.commodity().has_annotation() ?
-    find_by_name(amt.commodity()) : amounts.find(&amt.commodity());
+  // The pool creates one commodity for each distinct annotation, so an
+  // annotated commodity can be found by address like any other.
+  amounts_map::iterator i = amounts.find(&amt.commodity());
   if (i != amounts.end())
     i->second += amt;
   else
@@ -103,9 +104,7 @@ balance_t& balance_t::operator-=(const amount_t& amt)
   if (amt.is_realzero())
     return *this;
 
-  amounts_map::iterator i =
-    amt.commodity().has_annotation() ?
-    find_by_name(amt.commodity()) : amounts.find(&amt.commodity());
+  amounts_map::iterator i = amounts.find(&amt.commodity());
   if (i != amounts.end()) {
     i->second -= amt;
     if (i->second.is_realzero())
@@ -262,6 +261,9 @@ balance_t::commodity_amount(const optional<const commodity_t&>& commodity) const
 balance_t
 balance_t::strip_annotations(const keep_details_t& what_to_keep) const
 {
+  if (! needs_stripping(what_to_keep))
+    return *this;
+
   balance_t temp;
 
   foreach (const amounts_map::value_type& pair, amounts)
@@ -270,6 +272,18 @@ balance_t::strip_annotations(const keep_details_t& what_to_keep) const
   return temp;
 }
 
+bool balance_t::needs_stripping(const keep_details_t& what_to_keep) const
+{
+  if (what_to_keep.keep_all())
+    return false;
+
+  foreach (const amounts_map::value_type& pair, amounts)
+    if (pair.first->has_annotation() &&
+        &pair.first->strip_annotations(what_to_keep) != pair.first)
+      return true;
+  return false;
+}
+
 void balance_t::sorted_amounts(amounts_array& sorted) const
 {
   foreach (const amounts_map::value_type& pair, amounts)
@@ -377,61 +391,7 @@ void put_balance(property_tree::ptree& st, const balance_t& bal)
 
 balance_t average_lot_prices(const balance_t& bal)
 {
-  // First, we split the balance into multiple balances by underlying
-  // commodity.
-  typedef std::map<optional<std::string>,
-                   std::pair<amount_t, annotation_t> > balance_map;
-  balance_map bycomm;
-
-  foreach (const balance_t::amounts_map::value_type& pair, bal.amounts) {
-    optional<std::string> sym(pair.first->symbol());
-    amount_t quant(pair.second.strip_annotations(keep_details_t()));
-
-    balance_map::iterator i = bycomm.find(sym);
-    if (i == bycomm.end()) {
-      bycomm.insert(
-        balance_map::value_type(sym, std::make_pair(quant, annotation_t())));
-      i = bycomm.find(sym);    // must succeed now
-    } else {
-      (*i).second.first += quant;
-    }
-
-    if (pair.first->has_annotation()) {
-      annotated_commodity_t& acomm(static_cast<annotated_commodity_t&>(*pair.first));
-      annotation_t& ann((*i).second.second);
-
-      if (acomm.details.price) {
-        if (ann.price)
-          ann.price = *ann.price + (*acomm.details.price * quant);
-        else
-          ann.price = *acomm.details.price * quant;
-      }
-
-      if (acomm.details.date) {
-        if (! ann.date || *acomm.details.date < *ann.date)
-          ann.date = *acomm.details.date;
-      }
-    }
-  }
-
-  balance_t result;
-
-  foreach (balance_map::value_type& pair, bycomm) {
-    amount_t amt(pair.second.first);
-    if (! amt.is_realzero()) {
-      if (pair.second.second.price)
-        pair.second.second.price = *pair.second.second.price / amt;
-
-      commodity_t * acomm =
-        commodity_pool_t::current_pool->find_or_create(
-          amt.commodity(), pair.second.second);
-      amt.set_commodity(*acomm);
-
-      result += amt;
-    }
-  }
-
-  return result;
+  return inventory_t(bal).average_lot_prices();
 }
 
 } // namespace ledger
@@ -522,8 +522,12 @@ public:
    * will return a balance all of whose component amount have had
    * their commodity annotations likewise stripped.  See
    * amount_t::strip_annotations for more details.
+   *
+   * needs_stripping returns false when stripping would leave every
+   * amount as it is, in which case strip_annotations returns a copy.
    */
   balance_t strip_annotations(const keep_details_t& what_to_keep) const;
+  bool needs_stripping(const keep_details_t& what_to_keep) const;
 
   /**
    * Given a balance, insert a commodity-wise sort of the amounts into the
@@ -36,9 +36,39 @@
 #include "filters.h"
 #include "report.h"
 #include "session.h"
+#include "profile.h"
 
 namespace ledger {
 
+namespace {
+  // Put a profile_posts in front of every handler from HANDLER on, up to
+  // the first one that is already being profiled.
+  post_handler_ptr profile_handlers(post_handler_ptr handler)
+  {
+    std::vector<post_handler_ptr *> links;
+    for (post_handler_ptr * link = &handler;
+         *link && ! dynamic_cast<profile_posts *>(link->get());
+         link = &(*link)->next_handler())
+      links.push_back(link);
+
+    // Stages are reported in the order posts flow through them.  Each
+    // chain is built back to front, and a chain built later feeds the
+    // ones built before it, so every new stage goes to the front.
+    for (std::vector<post_handler_ptr *>::reverse_iterator i = links.rbegin();
+         i != links.rend();
+         i++) {
+      post_handler_ptr stage(**i);
+
+      string name(core::demangle(typeid(*stage).name()));
+      if (name.compare(0, 8, "ledger::") == 0)
+        name.erase(0, 8);
+
+      (*i)->reset(new profile_posts(stage, add_profile_stage(name)));
+    }
+    return handler;
+  }
+}
+
 post_handler_ptr chain_pre_post_handlers(post_handler_ptr base_handler,
                                          report_t&        report)
 {
@@ -50,13 +80,20 @@ post_handler_ptr chain_pre_post_handlers(post_handler_ptr base_handler,
     handler.reset(new anonymize_posts(handler));
 
   // This filter_posts will only pass through posts matching the `predicate'.
+  // If the next handler is a register_posts, and nothing else comes before
+  // it, it can do the filtering itself.
   if (report.HANDLED(limit_)) {
     DEBUG("report.predicate",
           "Report predicate expression = " << report.HANDLER(limit_).str());
-    handler.reset(new filter_posts
-                  (handler, predicate_t(report.HANDLER(limit_).str(),
-                                        report.what_to_keep()),
-                   report));
+    predicate_t limit_predicate(report.HANDLER(limit_).str(),
+                                report.what_to_keep());
+    register_posts * fused = NULL;
+    if (report.budget_flags == BUDGET_NO_BUDGET)
+      fused = dynamic_cast<register_posts *>(handler.get());
+    if (fused)
+      fused->set_limit_predicate(limit_predicate);
+    else
+      handler.reset(new filter_posts(handler, limit_predicate, report));
   }
 
   // budget_posts takes a set of posts from a data file and uses them to
@@ -102,12 +139,16 @@ post_handler_ptr chain_pre_post_handlers(post_handler_ptr base_handler,
                      report));
   }
 
+  if (profile_enabled)
+    handler = profile_handlers(handler);
+
   return handler;
 }
 
 post_handler_ptr chain_post_handlers(post_handler_ptr base_handler,
                                      report_t&        report,
-                                     bool             for_accounts_report)
+                                     bool             for_accounts_report,
+                                     bool             in_journal_order)
 {
   post_handler_ptr       handler(base_handler);
   predicate_t            display_predicate;
@@ -140,6 +181,21 @@ post_handler_ptr chain_post_handlers(post_handler_ptr base_handler,
                             report.HANDLED(tail_) ?
                             lexical_cast<int>(report.HANDLER(tail_).value) : 0));
 
+    // When nothing but the display predicate and the running total lies
+    // between here and the pre-post handlers, register_posts does all
+    // of their work in one handler.
+    if (register_posts::applicable(report)) {
+      if (report.HANDLED(display_))
+        display_predicate = predicate_t(report.HANDLER(display_).str(),
+                                        report.what_to_keep());
+      handler.reset(new register_posts(handler, report, display_predicate));
+
+      if (profile_enabled)
+        handler = profile_handlers(handler);
+
+      return handler;
+    }
+
     // display_filter_posts adds virtual posts to the list to account
     // for changes in value of commodities, which otherwise would affect
     // the running total unpredictably.
@@ -218,12 +274,25 @@ post_handler_ptr chain_post_handlers(post_handler_ptr base_handler,
     handler.reset(new by_payee_posts(handler, expr));
 
   // interval_posts groups posts together based on a time period, such as
-  // weekly or monthly.
-  if (report.HANDLED(period_))
+  // weekly or monthly.  If the posts will reach it in date order, it can
+  // report each period as soon as it is complete, instead of holding on
+  // to every post until the end.
+  if (report.HANDLED(period_)) {
+    journal_t& journal(*report.session.journal);
+    bool presorted = (in_journal_order &&
+                      (item_t::use_aux_date ?
+                       journal.sorted_by_aux_date : journal.sorted_by_date) &&
+                      ! report.HANDLED(date_) &&
+                      ! report.HANDLED(related) &&
+                      report.budget_flags == BUDGET_NO_BUDGET &&
+                      ! report.HANDLED(forecast_while_));
+
     handler.reset(new interval_posts(handler, expr,
                                      report.HANDLER(period_).str(),
                                      report.HANDLED(exact),
-                                     report.HANDLED(empty)));
+                                     report.HANDLED(empty),
+                                     presorted));
+  }
 
   if (report.HANDLED(date_))
     handler.reset(new transfer_details(handler, transfer_details::SET_DATE,
@@ -262,6 +331,9 @@ post_handler_ptr chain_post_handlers(post_handler_ptr base_handler,
     handler.reset(new inject_posts(handler, report.HANDLED(inject_).str(),
                                    report.session.journal->master));
 
+  if (profile_enabled)
+    handler = profile_handlers(handler);
+
   return handler;
 }
 
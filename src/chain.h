@@ -86,6 +86,12 @@ public:
     if (handler)
       handler->clear();
   }
+
+  // The handler this one passes its items on to; --profile splices its
+  // counting handlers in here.
+  shared_ptr<item_handler>& next_handler() {
+    return handler;
+  }
 };
 
 typedef shared_ptr<item_handler<post_t> > post_handler_ptr;
@@ -100,7 +106,8 @@ chain_pre_post_handlers(post_handler_ptr base_handler,
 post_handler_ptr
 chain_post_handlers(post_handler_ptr base_handler,
                     report_t&        report,
-                    bool             for_accounts_report = false);
+                    bool             for_accounts_report = false,
+                    bool             in_journal_order    = false);
 
 inline post_handler_ptr
 chain_handlers(post_handler_ptr handler,
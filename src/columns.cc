@@ -0,0 +1,411 @@
+/*
+ * Copyright (c) 2003-2018, John Wiegley.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * - Neither the name of New Artisans LLC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <system.hh>
+
+#include "columns.h"
+#include "journal.h"
+#include "xact.h"
+#include "post.h"
+#include "account.h"
+#include "commodity.h"
+
+namespace ledger {
+
+namespace {
+  template <typename T, typename Map>
+  post_columns_t::id_t intern(const T& value, Map& ids,
+                              std::vector<T>& table)
+  {
+    std::pair<typename Map::iterator, bool> result =
+      ids.insert(typename Map::value_type
+                 (value, static_cast<post_columns_t::id_t>(table.size())));
+    if (result.second)
+      table.push_back(value);
+    return result.first->second;
+  }
+
+  const uint_least8_t max_places = 18;
+
+  const long powers_of_ten[max_places + 1] = {
+    1L, 10L, 100L, 1000L, 10000L, 100000L, 1000000L, 10000000L,
+    100000000L, 1000000000L, 10000000000L, 100000000000L,
+    1000000000000L, 10000000000000L, 100000000000000L,
+    1000000000000000L, 10000000000000000L, 100000000000000000L,
+    1000000000000000000L
+  };
+
+  // Multiply value by 10^places, unless that would overflow a long
+  bool scale_up(long& value, const uint_least8_t places)
+  {
+    const long factor = powers_of_ten[places];
+    if (value > LONG_MAX / factor || value < LONG_MIN / factor)
+      return false;
+    value *= factor;
+    return true;
+  }
+}
+
+post_columns_t::post_columns_t(journal_t& journal)
+{
+  TRACE_CTOR(post_columns_t, "journal_t&");
+
+  std::unordered_map<account_t *, id_t>   account_ids;
+  std::unordered_map<commodity_t *, id_t> commodity_ids;
+  std::unordered_map<string, id_t>        payee_ids;
+
+  foreach (xact_t * xact, journal.xacts) {
+    foreach (post_t * post, xact->posts) {
+      posts.push_back(post);
+      days.push_back(post->primary_date().day_number());
+      accounts.push_back(intern(post->account, account_ids, account_table));
+      payees.push_back(intern(post->payee(), payee_ids, payee_table));
+
+      uint_least8_t row_flags = 0;
+      if (post->state() == item_t::CLEARED)
+        row_flags |= POST_COLUMN_CLEARED;
+      else if (post->state() == item_t::PENDING)
+        row_flags |= POST_COLUMN_PENDING;
+      if (post->has_flags(POST_VIRTUAL))
+        row_flags |= POST_COLUMN_VIRTUAL;
+      if (post->has_flags(ITEM_GENERATED | ITEM_TEMP))
+        row_flags |= POST_COLUMN_GENERATED;
+
+      // Only amounts whose totals print the same however they are summed
+      // are kept exactly: an amount with no commodity, or one which
+      // keeps its precision, prints at the precision of the sum, and a
+      // balance drops zero amounts which a single amount would add.
+      const amount_t& amount(post->amount);
+      long            quantity = 0;
+      if (! amount.is_null() && amount.has_commodity() &&
+          ! amount.keep_precision() && ! amount.is_realzero() &&
+          amount.precision() <= max_places &&
+          amount.to_scaled_long(amount.precision(), quantity))
+        row_flags |= POST_COLUMN_EXACT;
+
+      commodities.push_back
+        (amount.is_null() ? 0 :
+         intern(&amount.commodity(), commodity_ids, commodity_table));
+      quantities.push_back(quantity);
+      places.push_back(static_cast<uint_least8_t>
+                       (row_flags & POST_COLUMN_EXACT ?
+                        amount.precision() : 0));
+      flags.push_back(row_flags);
+    }
+  }
+
+  DEBUG("journal.columns", "Built columns for " << posts.size()
+        << " postings, " << account_table.size() << " accounts, "
+        << commodity_table.size() << " commodities and "
+        << payee_table.size() << " payees");
+}
+
+namespace {
+  typedef std::vector<uint_least8_t> selection_t;
+
+  void select_flags(const post_columns_t& columns, selection_t& selected,
+                    const uint_least8_t mask, const uint_least8_t value)
+  {
+    const uint_least8_t * row_flags = columns.flags.data();
+    for (std::size_t i = 0, n = columns.size(); i < n; i++)
+      selected[i] = (row_flags[i] & mask) == value;
+  }
+
+  void select_ids(const std::vector<post_columns_t::id_t>& ids,
+                  const selection_t& matches, selection_t& selected)
+  {
+    const post_columns_t::id_t * row_ids = ids.data();
+    for (std::size_t i = 0, n = ids.size(); i < n; i++)
+      selected[i] = matches[row_ids[i]];
+  }
+
+  template <typename Compare>
+  void select_days(const post_columns_t& columns, selection_t& selected,
+                   const uint_least32_t day, Compare compare)
+  {
+    const uint_least32_t * row_days = columns.days.data();
+    for (std::size_t i = 0, n = columns.size(); i < n; i++)
+      selected[i] = compare(row_days[i], day);
+  }
+
+  bool select_match(const post_columns_t& columns, const string& name,
+                    const mask_t& mask, selection_t& selected)
+  {
+    selection_t matches;
+    if (name == "account") {
+      foreach (account_t * account, columns.account_table)
+        matches.push_back(mask.match(account->fullname()));
+      select_ids(columns.accounts, matches, selected);
+    }
+    else if (name == "payee") {
+      foreach (const string& payee, columns.payee_table)
+        matches.push_back(mask.match(payee));
+      select_ids(columns.payees, matches, selected);
+    }
+    else {
+      return false;
+    }
+    return true;
+  }
+
+  bool select_date(const post_columns_t& columns,
+                   const expr_t::op_t::kind_t kind,
+                   const date_t& date, selection_t& selected)
+  {
+    const uint_least32_t day = date.day_number();
+    switch (kind) {
+    case expr_t::op_t::O_EQ:
+      select_days(columns, selected, day, std::equal_to<uint_least32_t>());
+      break;
+    case expr_t::op_t::O_LT:
+      select_days(columns, selected, day, std::less<uint_least32_t>());
+      break;
+    case expr_t::op_t::O_LTE:
+      select_days(columns, selected, day,
+                  std::less_equal<uint_least32_t>());
+      break;
+    case expr_t::op_t::O_GT:
+      select_days(columns, selected, day, std::greater<uint_least32_t>());
+      break;
+    case expr_t::op_t::O_GTE:
+      select_days(columns, selected, day,
+                  std::greater_equal<uint_least32_t>());
+      break;
+    default:
+      return false;
+    }
+    return true;
+  }
+
+  bool select_state(const post_columns_t& columns, const string& name,
+                    selection_t& selected)
+  {
+    const uint_least8_t states = POST_COLUMN_CLEARED | POST_COLUMN_PENDING;
+
+    if (name == "cleared")
+      select_flags(columns, selected, states, POST_COLUMN_CLEARED);
+    else if (name == "pending")
+      select_flags(columns, selected, states, POST_COLUMN_PENDING);
+    else if (name == "uncleared")
+      select_flags(columns, selected, states, 0);
+    else if (name == "real")
+      select_flags(columns, selected, POST_COLUMN_VIRTUAL, 0);
+    else if (name == "virtual")
+      select_flags(columns, selected, POST_COLUMN_VIRTUAL,
+                   POST_COLUMN_VIRTUAL);
+    else if (name == "actual")
+      select_flags(columns, selected, POST_COLUMN_GENERATED, 0);
+    else
+      return false;
+    return true;
+  }
+
+  // Each posting's totals, summed as an integer count of 10^-places units
+  struct column_sum_t
+  {
+    long          total;
+    long          real_total;
+    uint_least8_t places;
+    uint_least8_t real_places;
+    bool          has_real;
+
+    column_sum_t()
+      : total(0), real_total(0), places(0), real_places(0),
+        has_real(false) {}
+  };
+
+  bool add_scaled(long& sum, uint_least8_t& sum_places,
+                  long value, const uint_least8_t places)
+  {
+    if (places > sum_places) {
+      if (! scale_up(sum, places - sum_places))
+        return false;
+      sum_places = places;
+    }
+    else if (places < sum_places) {
+      if (! scale_up(value, sum_places - places))
+        return false;
+    }
+
+    if ((value > 0 && sum > LONG_MAX - value) ||
+        (value < 0 && sum < LONG_MIN - value))
+      return false;
+    sum += value;
+    return true;
+  }
+}
+
+bool post_columns_t::select(const expr_t::op_t& predicate,
+                            selection_t&        selected) const
+{
+  selected.resize(size());
+
+  switch (predicate.kind) {
+  case expr_t::op_t::IDENT:
+    return select_state(*this, predicate.as_ident(), selected);
+
+  case expr_t::op_t::O_NOT: {
+    if (! select(*predicate.left(), selected))
+      return false;
+    for (std::size_t i = 0, n = size(); i < n; i++)
+      selected[i] ^= 1;
+    return true;
+  }
+
+  case expr_t::op_t::O_AND:
+  case expr_t::op_t::O_OR: {
+    selection_t right;
+    if (! select(*predicate.left(), selected) ||
+        ! select(*predicate.right(), right))
+      return false;
+    if (predicate.kind == expr_t::op_t::O_AND) {
+      for (std::size_t i = 0, n = size(); i < n; i++)
+        selected[i] &= right[i];
+    } else {
+      for (std::size_t i = 0, n = size(); i < n; i++)
+        selected[i] |= right[i];
+    }
+    return true;
+  }
+
+  case expr_t::op_t::O_MATCH:
+    if (predicate.left()->is_ident() && predicate.right()->is_value() &&
+        predicate.right()->as_value().is_mask())
+      return select_match(*this, predicate.left()->as_ident(),
+                          predicate.right()->as_value().as_mask(), selected);
+    return false;
+
+  case expr_t::op_t::O_EQ:
+  case expr_t::op_t::O_LT:
+  case expr_t::op_t::O_LTE:
+  case expr_t::op_t::O_GT:
+  case expr_t::op_t::O_GTE:
+    if (predicate.left()->is_ident() &&
+        (predicate.left()->as_ident() == "date" ||
+         predicate.left()->as_ident() == "d") &&
+        predicate.right()->is_value() &&
+        predicate.right()->as_value().is_date())
+      return select_date(*this, predicate.kind,
+                         predicate.right()->as_value().as_date(), selected);
+    return false;
+
+  default:
+    return false;
+  }
+}
+
+bool post_columns_t::apply_totals(const expr_t::ptr_op_t& predicate)
+{
+  selection_t selected;
+  if (! predicate)
+    selected.assign(size(), 1);
+  else if (! select(*predicate, selected))
+    return false;
+
+  enum account_use_t { UNUSED, SUMMED, VISITED };
+  std::vector<account_use_t> uses(account_table.size(), UNUSED);
+
+  typedef std::pair<id_t, id_t> sum_key_t;
+  std::map<sum_key_t, column_sum_t> sums;
+
+  for (std::size_t i = 0, n = size(); i < n; i++) {
+    if (! selected[i])
+      continue;
+
+    account_use_t& use(uses[accounts[i]]);
+    if (use == VISITED)
+      continue;
+    use = SUMMED;
+
+    if (! (flags[i] & POST_COLUMN_EXACT)) {
+      use = VISITED;
+      continue;
+    }
+
+    column_sum_t& sum(sums[sum_key_t(accounts[i], commodities[i])]);
+    if (! add_scaled(sum.total, sum.places, quantities[i], places[i]))
+      use = VISITED;
+    if (! (flags[i] & POST_COLUMN_VIRTUAL)) {
+      sum.has_real = true;
+      if (! add_scaled(sum.real_total, sum.real_places,
+                       quantities[i], places[i]))
+        use = VISITED;
+    }
+  }
+
+  // A total which comes to zero would be left in a different form by
+  // adding the amounts one at a time, so those accounts are visited too
+  typedef std::map<sum_key_t, column_sum_t>::value_type sum_pair_t;
+  foreach (const sum_pair_t& pair, sums)
+    if (pair.second.total == 0 ||
+        (pair.second.has_real && pair.second.real_total == 0))
+      uses[pair.first.first] = VISITED;
+
+  foreach (const sum_pair_t& pair, sums) {
+    if (uses[pair.first.first] != SUMMED)
+      continue;
+
+    account_t::xdata_t::details_t&
+      details(account_table[pair.first.first]->xdata().self_details);
+    commodity_t * comm = commodity_table[pair.first.second];
+
+    amount_t total(amount_t::scaled(pair.second.total, pair.second.places));
+    total.set_commodity(*comm);
+    add_or_set_value(details.total, total);
+
+    if (pair.second.has_real) {
+      amount_t real_total(amount_t::scaled(pair.second.real_total,
+                                           pair.second.real_places));
+      real_total.set_commodity(*comm);
+      add_or_set_value(details.real_total, real_total);
+    }
+  }
+
+  for (std::size_t i = 0, n = size(); i < n; i++)
+    if (selected[i] && uses[accounts[i]] == VISITED)
+      posts[i]->xdata().add_flags(POST_EXT_VISITED);
+
+  for (std::size_t id = 0; id < account_table.size(); id++) {
+    if (uses[id] == UNUSED)
+      continue;
+
+    account_t& account(*account_table[id]);
+    // There are no visited postings left for account_t::amount to add
+    if (uses[id] == SUMMED)
+      account.xdata().self_details.last_post = account.posts.size();
+    account.xdata().add_flags(ACCOUNT_EXT_VISITED);
+  }
+
+  return true;
+}
+
+} // namespace ledger
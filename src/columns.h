@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2003-2018, John Wiegley.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * - Neither the name of New Artisans LLC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @addtogroup data
+ */
+
+/**
+ * @file   columns.h
+ * @author John Wiegley
+ *
+ * @ingroup data
+ *
+ * @brief  A snapshot of the journal's postings, one array per field
+ *
+ * Postings are separate heap objects reached through lists, so a
+ * report which only needs a few fields of each posting still follows a
+ * pointer, and evaluates an expression, for every one of them.  The
+ * columns copy those few fields into parallel arrays, where predicates
+ * over them become simple loops and amounts can be summed as integers.
+ */
+#ifndef _COLUMNS_H
+#define _COLUMNS_H
+
+#include "expr.h"
+
+namespace ledger {
+
+class journal_t;
+class post_t;
+class account_t;
+class commodity_t;
+
+#define POST_COLUMN_CLEARED   0x01 // state is cleared
+#define POST_COLUMN_PENDING   0x02 // state is pending
+#define POST_COLUMN_VIRTUAL   0x04 // the account was given in parens
+#define POST_COLUMN_GENERATED 0x08 // not an actual posting
+#define POST_COLUMN_EXACT     0x10 // quantity holds the amount exactly
+
+/**
+ * @class post_columns_t
+ *
+ * @brief The date, account, payee, state and amount of every posting.
+ *
+ * Row i of each array describes posts[i].  Accounts, commodities and
+ * payees are stored as indexes into tables of the distinct values, so
+ * that a test such as a regular expression match is made once per
+ * distinct value rather than once per posting.  An amount is stored as
+ * a long holding its quantity times 10^places, where places is its
+ * precision; a row whose amount cannot be held so lacks
+ * POST_COLUMN_EXACT.
+ */
+class post_columns_t : public noncopyable
+{
+public:
+  typedef uint_least32_t id_t;
+
+  std::vector<post_t *>       posts;
+  std::vector<uint_least32_t> days;
+  std::vector<id_t>           accounts;
+  std::vector<id_t>           commodities;
+  std::vector<id_t>           payees;
+  std::vector<long>           quantities;
+  std::vector<uint_least8_t>  places;
+  std::vector<uint_least8_t>  flags;
+
+  std::vector<account_t *>    account_table;
+  std::vector<commodity_t *>  commodity_table;
+  std::vector<string>         payee_table;
+
+  explicit post_columns_t(journal_t& journal);
+  ~post_columns_t() {
+    TRACE_DTOR(post_columns_t);
+  }
+
+  std::size_t size() const {
+    return posts.size();
+  }
+
+  /**
+   * Set selected[i] to 1 for each row the predicate is true of, and to
+   * 0 otherwise.  Only predicates over the columns can be answered:
+   * matches against account or payee, comparisons of date with a date,
+   * the state and kind of a posting, and &, | and ! of these.  Returns
+   * false for any other predicate.
+   */
+  bool select(const expr_t::op_t&          predicate,
+              std::vector<uint_least8_t>& selected) const;
+
+  /**
+   * Give every account the totals of its postings that satisfy the
+   * predicate, as the handler chain of a balance report would.  An
+   * account's totals are summed here as integers when all of its
+   * selected amounts are exact and no total comes to zero; for other
+   * accounts, the selected postings are only marked as visited, which
+   * leaves the summing to account_t::amount.  A null predicate selects
+   * every posting.  Returns false, doing nothing, if select() cannot
+   * answer the predicate.
+   */
+  bool apply_totals(const expr_t::ptr_op_t& predicate);
+};
+
+} // namespace ledger
+
+#endif // _COLUMNS_H
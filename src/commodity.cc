@@ -59,7 +59,7 @@ void commodity_t::add_price(const datetime_t& date, const amount_t& price,
 
   pool().commodity_price_history.add_price(referent(), date, price);
 
-  base->price_map.clear();    // a price was added, invalid the map
+  base->clear_price_map();    // a price was added, invalid the map
 }
 
 void commodity_t::remove_price(const datetime_t& date, commodity_t& commodity)
@@ -68,7 +68,7 @@ void commodity_t::remove_price(const datetime_t& date, commodity_t& commodity)
 
   DEBUG("history.find", "Removing price: " << symbol() << " on " << date);
 
-  base->price_map.clear();  // a price was added, invalid the map
+  base->clear_price_map();  // a price was added, invalid the map
 }
 
 void commodity_t::map_prices(function<void(datetime_t, const amount_t&)> fn,
@@ -138,13 +138,16 @@ commodity_t::find_price(const commodity_t * commodity,
         << (! moment.is_not_a_date_time() ? format_datetime(moment) : "NONE") << ", "
         << (! oldest.is_not_a_date_time() ? format_datetime(oldest) : "NONE") << ", "
         << (commodity ? commodity->symbol()      : "NONE"));
+  std::size_t generation;
   {
+    std::lock_guard<std::mutex> guard(base->price_map_mutex);
     base_t::memoized_price_map::iterator i = base->price_map.find(entry);
     if (i != base->price_map.end()) {
       DEBUG("commodity.price.find", "found! returning: "
             << ((*i).second ? (*i).second->price : amount_t(0L)));
       return (*i).second;
     }
+    generation = base->price_map_generation;
   }
 
   datetime_t when;
@@ -165,6 +168,10 @@ commodity_t::find_price(const commodity_t * commodity,
           pool().commodity_price_history.find_price(referent(), when, oldest));
 
   // Record this price point in the memoization map
+  std::lock_guard<std::mutex> guard(base->price_map_mutex);
+  if (generation != base->price_map_generation)
+    return point;
+
   if (base->price_map.size() > base_t::max_price_map_size) {
     DEBUG("history.find",
           "price map has grown too large, clearing it by half");
@@ -364,6 +371,62 @@ void commodity_t::parse_symbol(std::istream& in, string& symbol)
   }
 }
 
+bool commodity_t::parse_symbol(const char *& p, string& symbol)
+{
+  const char * b = p;
+  while (std::isspace(static_cast<unsigned char>(*b)))
+    b++;
+  if (*b == '"')
+    return false;
+
+  const char * q = b;
+  while (*q && *q != '\n') {
+    if (q - b >= 240)
+      return false;
+
+    std::size_t   bytes = 0;
+    unsigned char d     = static_cast<unsigned char>(*q);
+
+    // Check for the start of a UTF-8 multi-byte encoded string
+    if (d >= 192 && d <= 223)
+      bytes = 2;
+    else if (d >= 224 && d <= 239)
+      bytes = 3;
+    else if (d >= 240 && d <= 247)
+      bytes = 4;
+    else if (d >= 248 && d <= 251)
+      bytes = 5;
+    else if (d >= 252 && d <= 253)
+      bytes = 6;
+    else if (d >= 254) // UTF-8 encoding error
+      break;
+
+    if (bytes > 0) {            // we're looking at a UTF-8 encoding
+      for (std::size_t i = 0; i < bytes; i++)
+        if (! q[i])
+          throw_(amount_error, _("Invalid UTF-8 encoding for commodity name"));
+      q += bytes;
+    }
+    else if (invalid_chars[d]) {
+      break;
+    }
+    else if (d == '\\') {
+      return false;
+    }
+    else {
+      q++;
+    }
+  }
+
+  symbol.assign(b, static_cast<std::string::size_type>(q - b));
+  if (is_reserved_token(symbol.c_str()))
+    symbol.clear();
+
+  if (! symbol.empty())
+    p = q;
+  return true;
+}
+
 void commodity_t::parse_symbol(char *& p, string& symbol)
 {
   if (*p == '"') {
@@ -111,8 +111,19 @@ protected:
     typedef std::map<memoized_price_entry,
                      optional<price_point_t> > memoized_price_map;
 
+    // The memo is consulted and updated under price_map_mutex.  Every
+    // clearing bumps the generation, so that a price found before a new
+    // price point was added is not remembered afterward.
     static const std::size_t   max_price_map_size = 8;
     mutable memoized_price_map price_map;
+    mutable std::size_t        price_map_generation;
+    mutable std::mutex         price_map_mutex;
+
+    void clear_price_map() {
+      std::lock_guard<std::mutex> guard(price_map_mutex);
+      price_map.clear();
+      ++price_map_generation;
+    }
 
   public:
     explicit base_t(const string& _symbol)
@@ -120,7 +131,7 @@ protected:
         (commodity_t::decimal_comma_by_default ?
          static_cast<uint_least16_t>(COMMODITY_STYLE_DECIMAL_COMMA) :
          static_cast<uint_least16_t>(COMMODITY_STYLE_DEFAULTS)),
-        symbol(_symbol), precision(0) {
+        symbol(_symbol), precision(0), price_map_generation(0) {
       TRACE_CTOR(commodity_t::base_t, "const string&");
     }
     virtual ~base_t() {
@@ -268,6 +279,11 @@ public:
 
   static void parse_symbol(std::istream& in, string& symbol);
   static void parse_symbol(char *& p, string& symbol);
+
+  // Read a symbol at P the way parse_symbol(std::istream&) would, moving P
+  // past it if one is found.  Returns false for symbols that only the
+  // stream version reads: quoted, escaped or overly long ones.
+  static bool parse_symbol(const char *& p, string& symbol);
   static string parse_symbol(std::istream& in) {
     string temp;
     parse_symbol(in, temp);
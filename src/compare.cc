@@ -81,26 +81,39 @@ void compare_items<account_t>::find_sort_values(
 }
 
 template <>
-bool compare_items<post_t>::operator()(post_t * left, post_t * right)
+const std::list<sort_value_t>&
+compare_items<post_t>::sort_values_for(post_t * post)
 {
-  assert(left);
-  assert(right);
-
-  post_t::xdata_t& lxdata(left->xdata());
-  if (! lxdata.has_flags(POST_EXT_SORT_CALC)) {
-    bind_scope_t bound_scope(*sort_order.get_context(), *left);
-    find_sort_values(lxdata.sort_values, bound_scope);
-    lxdata.add_flags(POST_EXT_SORT_CALC);
+  post_t::xdata_t& xdata(post->xdata());
+  if (! xdata.has_flags(POST_EXT_SORT_CALC)) {
+    bind_scope_t bound_scope(*sort_order.get_context(), *post);
+    find_sort_values(xdata.sort_values, bound_scope);
+    xdata.add_flags(POST_EXT_SORT_CALC);
   }
+  return xdata.sort_values;
+}
 
-  post_t::xdata_t& rxdata(right->xdata());
-  if (! rxdata.has_flags(POST_EXT_SORT_CALC)) {
-    bind_scope_t bound_scope(*sort_order.get_context(), *right);
-    find_sort_values(rxdata.sort_values, bound_scope);
-    rxdata.add_flags(POST_EXT_SORT_CALC);
+template <>
+const std::list<sort_value_t>&
+compare_items<account_t>::sort_values_for(account_t * account)
+{
+  account_t::xdata_t& xdata(account->xdata());
+  if (! xdata.has_flags(ACCOUNT_EXT_SORT_CALC)) {
+    bind_scope_t bound_scope(*sort_order.get_context(), *account);
+    find_sort_values(xdata.sort_values, bound_scope);
+    xdata.add_flags(ACCOUNT_EXT_SORT_CALC);
   }
+  return xdata.sort_values;
+}
 
-  return sort_value_is_less_than(lxdata.sort_values, rxdata.sort_values);
+template <>
+bool compare_items<post_t>::operator()(post_t * left, post_t * right)
+{
+  assert(left);
+  assert(right);
+
+  return sort_value_is_less_than(sort_values_for(left),
+                                 sort_values_for(right));
 }
 
 template <>
@@ -109,24 +122,13 @@ bool compare_items<account_t>::operator()(account_t * left, account_t * right)
   assert(left);
   assert(right);
 
-  account_t::xdata_t& lxdata(left->xdata());
-  if (! lxdata.has_flags(ACCOUNT_EXT_SORT_CALC)) {
-    bind_scope_t bound_scope(*sort_order.get_context(), *left);
-    find_sort_values(lxdata.sort_values, bound_scope);
-    lxdata.add_flags(ACCOUNT_EXT_SORT_CALC);
-  }
-
-  account_t::xdata_t& rxdata(right->xdata());
-  if (! rxdata.has_flags(ACCOUNT_EXT_SORT_CALC)) {
-    bind_scope_t bound_scope(*sort_order.get_context(), *right);
-    find_sort_values(rxdata.sort_values, bound_scope);
-    rxdata.add_flags(ACCOUNT_EXT_SORT_CALC);
-  }
+  const std::list<sort_value_t>& left_values(sort_values_for(left));
+  const std::list<sort_value_t>& right_values(sort_values_for(right));
 
   DEBUG("value.sort", "Comparing accounts " << left->fullname()
         << " <> " << right->fullname());
 
-  return sort_value_is_less_than(lxdata.sort_values, rxdata.sort_values);
+  return sort_value_is_less_than(left_values, right_values);
 }
 
 } // namespace ledger
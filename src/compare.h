@@ -76,6 +76,10 @@ public:
 
   void find_sort_values(std::list<sort_value_t>& sort_values, scope_t& scope);
 
+  // Return the sort key of an item, calculating it the first time it is
+  // asked for and caching it in the item's xdata.
+  const std::list<sort_value_t>& sort_values_for(T * item);
+
   bool operator()(T * left, T * right);
 };
 
@@ -89,6 +93,13 @@ bool compare_items<T>::operator()(T * left, T * right)
                                  find_sort_values(right));
 }
 
+template <>
+const std::list<sort_value_t>&
+compare_items<post_t>::sort_values_for(post_t * post);
+template <>
+const std::list<sort_value_t>&
+compare_items<account_t>::sort_values_for(account_t * account);
+
 template <>
 bool compare_items<post_t>::operator()(post_t * left, post_t * right);
 template <>
@@ -90,6 +90,11 @@ expr_t::ptr_op_t expr_t::get_op() throw()
   return ptr;
 }
 
+void expr_t::set_op(ptr_op_t op) throw()
+{
+  ptr = op;
+}
+
 void expr_t::parse(std::istream& in, const parse_flags_t& flags,
                    const optional<string>& original_string)
 {
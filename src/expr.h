@@ -85,6 +85,7 @@ public:
   virtual operator bool() const throw();
 
   ptr_op_t get_op() throw();
+  void     set_op(ptr_op_t op) throw();
 
   void parse(const string& str, const parse_flags_t& flags = PARSE_DEFAULT) {
     std::istringstream stream(str);
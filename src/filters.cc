@@ -164,6 +164,201 @@ void sort_posts::post_accumulated_posts()
   posts.clear();
 }
 
+namespace {
+  enum term_class_t {
+    TERM_CONSTANT,
+    TERM_ACCOUNT,
+    TERM_PAYEE,
+    TERM_DATE,
+    TERM_OTHER
+  };
+
+  term_class_t ident_class(expr_t::ptr_op_t op)
+  {
+    // Only identifiers which were resolved to one of the posting's own
+    // accessor functions are considered; user definitions might depend on
+    // anything.
+    if (! op->left() || ! op->left()->is_function())
+      return TERM_OTHER;
+
+    const string& name(op->as_ident());
+    if (name == "account" || name == "account_base" || name == "depth")
+      return TERM_ACCOUNT;
+    else if (name == "payee")
+      return TERM_PAYEE;
+    else if (name == "date" || name == "d")
+      return TERM_DATE;
+    else
+      return TERM_OTHER;
+  }
+
+  term_class_t combine_classes(term_class_t left, term_class_t right)
+  {
+    if (left == TERM_CONSTANT)
+      return right;
+    else if (right == TERM_CONSTANT || left == right)
+      return left;
+    else
+      return TERM_OTHER;
+  }
+
+  bool is_memoizable_operator(expr_t::op_t::kind_t kind)
+  {
+    switch (kind) {
+    case expr_t::op_t::O_NOT:
+    case expr_t::op_t::O_NEG:
+    case expr_t::op_t::O_EQ:
+    case expr_t::op_t::O_LT:
+    case expr_t::op_t::O_LTE:
+    case expr_t::op_t::O_GT:
+    case expr_t::op_t::O_GTE:
+    case expr_t::op_t::O_AND:
+    case expr_t::op_t::O_OR:
+    case expr_t::op_t::O_ADD:
+    case expr_t::op_t::O_SUB:
+    case expr_t::op_t::O_MUL:
+    case expr_t::op_t::O_DIV:
+    case expr_t::op_t::O_QUERY:
+    case expr_t::op_t::O_COLON:
+    case expr_t::op_t::O_MATCH:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  term_class_t classify_term(expr_t::ptr_op_t op)
+  {
+    if (op->is_value())
+      return TERM_CONSTANT;
+    else if (op->is_ident())
+      return ident_class(op);
+    else if (! is_memoizable_operator(op->kind))
+      return TERM_OTHER;
+
+    term_class_t result = classify_term(op->left());
+    if (op->has_right())
+      result = combine_classes(result, classify_term(op->right()));
+    return result;
+  }
+
+  // Only terms which always yield a boolean can be stored as a simple
+  // true/false result; "and" and "or" pass through their operands' values.
+  bool is_boolean_term(expr_t::ptr_op_t op)
+  {
+    switch (op->kind) {
+    case expr_t::op_t::O_NOT:
+    case expr_t::op_t::O_EQ:
+    case expr_t::op_t::O_LT:
+    case expr_t::op_t::O_LTE:
+    case expr_t::op_t::O_GT:
+    case expr_t::op_t::O_GTE:
+    case expr_t::op_t::O_MATCH:
+      return true;
+    case expr_t::op_t::O_AND:
+    case expr_t::op_t::O_OR:
+      return is_boolean_term(op->left()) && is_boolean_term(op->right());
+    default:
+      return false;
+    }
+  }
+
+  typedef std::list<shared_ptr<filter_posts::memoized_term_t> >
+    memoized_terms_list;
+
+  expr_t::ptr_op_t memoize_term(expr_t::ptr_op_t     op,
+                                memoized_terms_list& terms)
+  {
+    if (! is_memoizable_operator(op->kind))
+      return op;
+
+    if (is_boolean_term(op)) {
+      optional<filter_posts::memoized_term_t::kind_t> kind;
+      switch (classify_term(op)) {
+      case TERM_ACCOUNT:
+        kind = filter_posts::memoized_term_t::ACCOUNT_TERM;
+        break;
+      case TERM_PAYEE:
+        kind = filter_posts::memoized_term_t::PAYEE_TERM;
+        break;
+      case TERM_DATE:
+        kind = filter_posts::memoized_term_t::DATE_TERM;
+        break;
+      default:
+        break;
+      }
+
+      if (kind) {
+        DEBUG("filters.memoize", "Memoizing term: " << op_context(op));
+
+        shared_ptr<filter_posts::memoized_term_t>
+          term(new filter_posts::memoized_term_t(*kind, op));
+        terms.push_back(term);
+        return expr_t::op_t::wrap_functor
+          (bind(&filter_posts::memoized_term_t::calc, term, _1));
+      }
+    }
+
+    expr_t::ptr_op_t lhs(memoize_term(op->left(), terms));
+    expr_t::ptr_op_t rhs(op->has_right() ?
+                         memoize_term(op->right(), terms) : NULL);
+
+    if (lhs == op->left() && (! rhs || rhs == op->right()))
+      return op;
+    else
+      return expr_t::op_t::new_node(op->kind, lhs, rhs);
+  }
+
+  template <typename ResultsMap>
+  bool memoized_result(ResultsMap&                            results,
+                       const typename ResultsMap::key_type& key,
+                       expr_t::ptr_op_t                       term,
+                       call_scope_t&                          args)
+  {
+    typename ResultsMap::iterator i = results.find(key);
+    if (i != results.end())
+      return (*i).second;
+
+    bool result = term->calc(args, args.locus, args.depth).to_boolean();
+    results.insert(typename ResultsMap::value_type(key, result));
+    return result;
+  }
+}
+
+value_t filter_posts::memoized_term_t::calc(call_scope_t& args)
+{
+  post_t& post(args.context<post_t>());
+
+  switch (kind) {
+  case ACCOUNT_TERM:
+    return memoized_result(account_results, post.reported_account(),
+                           term, args);
+  case PAYEE_TERM:
+    return memoized_result(payee_results, post.payee(), term, args);
+  case DATE_TERM:
+    return memoized_result(date_results, post.date().day_number(),
+                           term, args);
+  }
+  assert(false);
+  return NULL_VALUE;
+}
+
+void filter_posts::memoize_predicate(predicate_t&         pred,
+                                     scope_t&             scope,
+                                     memoized_terms_list& terms)
+{
+  if (pred) {
+    pred.compile(scope);
+    pred.set_op(memoize_term(pred.get_op(), terms));
+  }
+}
+
+void filter_posts::memoize_terms(scope_t& scope)
+{
+  memoize_predicate(pred, scope, memoized_terms);
+  memoized = true;
+}
+
 namespace {
   void split_string(const string& str, const char ch,
                     std::list<string>& strings)
@@ -587,6 +782,90 @@ void display_filter_posts::operator()(post_t& post)
     item_handler<post_t>::operator()(post);
 }
 
+register_posts::register_posts(post_handler_ptr   handler,
+                               report_t&          _report,
+                               const predicate_t& _display_predicate)
+  : item_handler<post_t>(handler), report(_report),
+    amount_expr(report.HANDLER(amount_).expr),
+    display_amount_expr(report.HANDLER(display_amount_).expr),
+    display_predicate(_display_predicate), memoized(false), last_post(NULL)
+{
+  TRACE_CTOR(register_posts, "post_handler_ptr, report_t&, predicate_t");
+}
+
+bool register_posts::applicable(report_t& report)
+{
+  return (! report.HANDLED(forecast_while_) &&
+          ! report.HANDLED(revalued) &&
+          ! report.HANDLED(only_) &&
+          ! report.HANDLED(sort_) &&
+          ! report.HANDLED(collapse) &&
+          ! report.HANDLED(equity) &&
+          ! report.HANDLED(subtotal) &&
+          ! report.HANDLED(dow) &&
+          ! report.HANDLED(by_payee) &&
+          ! report.HANDLED(period_) &&
+          ! report.HANDLED(date_) &&
+          ! report.HANDLED(account_) &&
+          ! report.HANDLED(pivot_) &&
+          ! report.HANDLED(payee_) &&
+          ! report.HANDLED(related) &&
+          ! report.HANDLED(inject_));
+}
+
+void register_posts::operator()(post_t& post)
+{
+  bind_scope_t bound_scope(report, post);
+  if (! memoized) {
+    filter_posts::memoize_predicate(limit_predicate, bound_scope,
+                                    memoized_terms);
+    filter_posts::memoize_predicate(display_predicate, bound_scope,
+                                    memoized_terms);
+    memoized = true;
+  }
+
+  // What the filter_posts for --limit would do
+  if (limit_predicate) {
+    if (! limit_predicate(bound_scope))
+      return;
+    post.xdata().add_flags(POST_EXT_MATCHES);
+  }
+
+  // What calc_posts would do, always keeping a running total
+  post_t::xdata_t& xdata(post.xdata());
+
+  if (last_post) {
+    assert(last_post->has_xdata());
+    xdata.total = last_post->xdata().total;
+    xdata.count = last_post->xdata().count + 1;
+  } else {
+    xdata.count = 1;
+  }
+  last_post = &post;
+
+  post.add_to_value(xdata.visited_value, amount_expr);
+  xdata.add_flags(POST_EXT_VISITED);
+
+  account_t * acct = post.reported_account();
+  acct->xdata().add_flags(ACCOUNT_EXT_VISITED);
+
+  add_or_set_value(xdata.total, xdata.visited_value);
+
+  // What the filter_posts for --display would do
+  if (display_predicate) {
+    if (! display_predicate(bound_scope))
+      return;
+    post.xdata().add_flags(POST_EXT_MATCHES);
+  }
+
+  // What display_filter_posts does without --revalued, which is the only
+  // case in which it would report rounding adjustments
+  if (report.HANDLED(empty) ||
+      display_amount_expr.calc(bound_scope)
+      .strip_annotations(report.what_to_keep()))
+    item_handler<post_t>::operator()(post);
+}
+
 changed_value_posts::changed_value_posts
   (post_handler_ptr       handler,
    report_t&              _report,
@@ -884,7 +1163,7 @@ void subtotal_posts::report_subtotal(const char *                     spec_fmt,
                  /* date=       */ *range_finish,
                  /* act_date_p= */ false);
 
-  values.clear();
+  clear_values();
 }
 
 void subtotal_posts::operator()(post_t& post)
@@ -899,27 +1178,32 @@ void subtotal_posts::operator()(post_t& post)
   post.xdata().compound_value = amount;
   post.xdata().add_flags(POST_EXT_COMPOUND);
 
-  values_map::iterator i = values.find(acct->fullname());
-  if (i == values.end()) {
-#if DEBUG_ON
-    std::pair<values_map::iterator, bool> result =
-#endif
-      values.insert(values_pair
-                    (acct->fullname(),
-                     acct_value_t(acct, amount, post.has_flags(POST_VIRTUAL),
-                                  post.has_flags(POST_MUST_BALANCE))));
-#if DEBUG_ON
-    assert(result.second);
-#endif
+  // Subtotals are kept in order of account name, but the same accounts
+  // are seen over and over, so remember where each one's subtotal lives
+  // rather than building and comparing its full name for every post.
+  values_map::iterator i;
+  values_by_account_map::iterator known = values_by_account.find(acct);
+  if (known != values_by_account.end()) {
+    i = (*known).second;
   } else {
-    if (post.has_flags(POST_VIRTUAL) != (*i).second.is_virtual)
-      throw_(std::logic_error,
-             _("'equity' cannot accept virtual and "
-               "non-virtual postings to the same account"));
-
-    add_or_set_value((*i).second.value, amount);
+    string fullname(acct->fullname());
+    i = values.find(fullname);
+    if (i == values.end())
+      i = values.insert(values_pair
+                        (fullname,
+                         acct_value_t(acct, post.has_flags(POST_VIRTUAL),
+                                      post.has_flags(POST_MUST_BALANCE))))
+        .first;
+    values_by_account.insert(values_by_account_map::value_type(acct, i));
   }
 
+  if (post.has_flags(POST_VIRTUAL) != (*i).second.is_virtual)
+    throw_(std::logic_error,
+           _("'equity' cannot accept virtual and "
+             "non-virtual postings to the same account"));
+
+  add_or_set_value((*i).second.value, amount);
+
   // If the account for this post is all virtual, mark it as
   // such, so that `handle_value' can show "(Account)" for accounts
   // that contain only virtual posts.
@@ -951,80 +1235,98 @@ namespace {
 void interval_posts::operator()(post_t& post)
 {
   // If there is a duration (such as weekly), we must generate the
-  // report in two passes.  Otherwise, we only have to check whether the
-  // post falls within the reporting period.
+  // report in two passes, unless the posts are known to arrive in date
+  // order.  Otherwise, we only have to check whether the post falls
+  // within the reporting period.
 
   if (interval.duration) {
-    all_posts.push_back(&post);
+    if (presorted)
+      add_to_period(post);
+    else
+      all_posts.push_back(&post);
   }
   else if (interval.find_period(post.date())) {
     item_handler<post_t>::operator()(post);
   }
 }
 
-void interval_posts::flush()
+void interval_posts::add_to_period(post_t& post)
 {
-  if (! interval.duration) {
-    item_handler<post_t>::flush();
-    return;
+  if (! started) {
+    // only if the interval has no start use the earliest post
+    if (!(interval.begin() && interval.find_period(*interval.begin())))
+      // Determine the beginning interval by using the earliest post
+      if (! interval.find_period(post.date()))
+        throw_(std::logic_error,
+               _("Failed to find period for interval report"));
+    started = true;
   }
 
-  // Sort all the postings we saw by date ascending
-  std::stable_sort(all_posts.begin(), all_posts.end(),
-                   sort_posts_by_date());
-
-  // only if the interval has no start use the earliest post
-  if (!(interval.begin() && interval.find_period(*interval.begin())))
-    // Determine the beginning interval by using the earliest post
-    if (all_posts.size() > 0 && all_posts.front()
-        && !interval.find_period(all_posts.front()->date()))
-      throw_(std::logic_error, _("Failed to find period for interval report"));
-
-  // Walk the interval forward reporting all posts within each one
-  // before moving on, until we reach the end of all_posts
-  bool saw_posts = false;
-  for (std::deque<post_t *>::iterator i = all_posts.begin();
-       i != all_posts.end(); ) {
-    post_t * post(*i);
-
+  // Walk the interval forward, reporting the posts seen within each
+  // period, until we reach the one containing this post
+  while (true) {
     DEBUG("filters.interval",
-          "Considering post " << post->date() << " = " << post->amount);
+          "Considering post " << post.date() << " = " << post.amount);
 #if DEBUG_ON
     DEBUG("filters.interval", "interval is:");
     debug_interval(interval);
 #endif
-    assert(! interval.finish || post->date() < *interval.finish);
+    assert(! interval.finish || post.date() < *interval.finish);
 
-    if (interval.within_period(post->date())) {
+    if (interval.within_period(post.date())) {
       DEBUG("filters.interval", "Calling subtotal_posts::operator()");
-      subtotal_posts::operator()(*post);
-      ++i;
+      subtotal_posts::operator()(post);
       saw_posts = true;
-    } else {
-      if (saw_posts) {
-        DEBUG("filters.interval",
-              "Calling subtotal_posts::report_subtotal()");
-        report_subtotal(interval);
-        saw_posts = false;
-      }
-      else if (generate_empty_posts) {
-        // Generate a null posting, so the intervening periods can be
-        // seen when -E is used, or if the calculated amount ends up
-        // being non-zero
-        xact_t& null_xact = temps.create_xact();
-        null_xact._date = interval.inclusive_end();
-
-        post_t& null_post = temps.create_post(null_xact, empty_account);
-        null_post.add_flags(POST_CALCULATED);
-        null_post.amount = 0L;
-
-        subtotal_posts::operator()(null_post);
-        report_subtotal(interval);
-      }
+      return;
+    }
 
-      DEBUG("filters.interval", "Advancing interval");
-      ++interval;
+    if (saw_posts) {
+      DEBUG("filters.interval",
+            "Calling subtotal_posts::report_subtotal()");
+      report_subtotal(interval);
+      saw_posts = false;
     }
+    else if (generate_empty_posts) {
+      // Generate a null posting, so the intervening periods can be
+      // seen when -E is used, or if the calculated amount ends up
+      // being non-zero
+      xact_t& null_xact = temps.create_xact();
+      null_xact._date = interval.inclusive_end();
+
+      post_t& null_post = temps.create_post(null_xact, empty_account);
+      null_post.add_flags(POST_CALCULATED);
+      null_post.amount = 0L;
+
+      subtotal_posts::operator()(null_post);
+      report_subtotal(interval);
+    }
+    else if (interval.find_period(post.date())) {
+      // Nothing needs reporting for the periods in between, so skip
+      // straight to the one containing this post
+      DEBUG("filters.interval", "Skipped ahead to the post's period");
+      continue;
+    }
+
+    DEBUG("filters.interval", "Advancing interval");
+    ++interval;
+  }
+}
+
+void interval_posts::flush()
+{
+  if (! interval.duration) {
+    item_handler<post_t>::flush();
+    return;
+  }
+
+  if (! presorted) {
+    // Sort all the postings we saw by date ascending
+    std::stable_sort(all_posts.begin(), all_posts.end(),
+                     sort_posts_by_date());
+
+    foreach (post_t * post, all_posts)
+      add_to_period(*post);
+    all_posts.clear();
   }
 
   // If the last postings weren't reported, do so now.
@@ -1032,6 +1334,7 @@ void interval_posts::flush()
     DEBUG("filters.interval",
           "Calling subtotal_posts::report_subtotal() at end");
     report_subtotal(interval);
+    saw_posts = false;
   }
 
   // Tell our parent class to flush
@@ -1116,7 +1419,7 @@ void posts_as_equity::report_subtotal()
     if (! pair.second.is_virtual || pair.second.must_balance)
       total += value;
   }
-  values.clear();
+  clear_values();
 
   // This last part isn't really needed, since an Equity:Opening
   // Balances posting with a null amount will automatically balance with
@@ -1396,22 +1699,27 @@ void forecast_posts::flush()
   // period, which is modified as we go.  This is found in the second member
   // of the pending_posts_list for each posting.
   //
-  // The algorithm below works by iterating through the N periodic postings
-  // over and over, until each of them meets the termination criteria for the
-  // forecast and is removed from the set.
-
-  while (pending_posts.size() > 0) {
-    // At each step through the loop, we find the first periodic posting whose
-    // period contains the earliest starting date.
-    pending_posts_list::iterator least = pending_posts.begin();
-    for (pending_posts_list::iterator i = ++pending_posts.begin();
-         i != pending_posts.end();
-         i++) {
-      assert((*i).first.start);
-      assert((*least).first.start);
-      if (*(*i).first.start < *(*least).first.start)
-        least = i;
-    }
+  // The algorithm below works by repeatedly taking the periodic posting
+  // whose period has the earliest starting date, until each of them meets
+  // the termination criteria for the forecast and is removed from the set.
+  // The postings are kept in a heap ordered by that date, and then by
+  // their position in `pending_posts', so that postings due on the same
+  // day are generated in the order they were defined.
+
+  std::vector<pending_posts_heap_entry> heap;
+  heap.reserve(pending_posts.size());
+  std::size_t sequence = 0;
+  for (pending_posts_list::iterator i = pending_posts.begin();
+       i != pending_posts.end();
+       i++) {
+    assert((*i).first.start);
+    heap.push_back(pending_posts_heap_entry(sequence++, i));
+  }
+  std::make_heap(heap.begin(), heap.end(), pending_post_is_later());
+
+  while (! heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), pending_post_is_later());
+    pending_posts_list::iterator least = heap.back().second;
 
 #if !NO_ASSERTS
     if ((*least).first.finish)
@@ -1430,6 +1738,7 @@ void forecast_posts::flush()
             "Forecast transaction exceeds " << forecast_years
             << " years beyond today");
       pending_posts.erase(least);
+      heap.pop_back();
       continue;
     }
 
@@ -1458,17 +1767,21 @@ void forecast_posts::flush()
       if (! pred(bound_scope)) {
         DEBUG("filters.forecast", "  fails to match continuation criteria");
         pending_posts.erase(least);
+        heap.pop_back();
         continue;
       }
     }
 
     // Increment the 'least', but remove it from pending_posts if it
-    // exceeds its own boundaries.
+    // exceeds its own boundaries.  Otherwise put it back in the heap
+    // under its new starting date.
     ++(*least).first;
     if (! (*least).first.start) {
       pending_posts.erase(least);
+      heap.pop_back();
       continue;
     }
+    std::push_heap(heap.begin(), heap.end(), pending_post_is_later());
   }
 
   item_handler<post_t>::flush();
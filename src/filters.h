@@ -47,6 +47,7 @@
 #include "post.h"
 #include "account.h"
 #include "temps.h"
+#include "profile.h"
 
 namespace ledger {
 
@@ -175,6 +176,31 @@ public:
   }
 };
 
+class profile_posts : public item_handler<post_t>
+{
+  profile_stage_t& stage;
+
+  profile_posts();
+
+public:
+  profile_posts(post_handler_ptr handler, profile_stage_t& _stage)
+    : item_handler<post_t>(handler), stage(_stage) {
+    TRACE_CTOR(profile_posts, "post_handler_ptr, profile_stage_t&");
+  }
+  virtual ~profile_posts() {
+    TRACE_DTOR(profile_posts);
+  }
+
+  virtual void flush() {
+    profile_scope_t scope(stage, true);
+    item_handler<post_t>::flush();
+  }
+  virtual void operator()(post_t& post) {
+    profile_scope_t scope(stage);
+    item_handler<post_t>::operator()(post);
+  }
+};
+
 class push_to_posts_list : public item_handler<post_t>
 {
   push_to_posts_list();
@@ -323,16 +349,76 @@ public:
 
 class filter_posts : public item_handler<post_t>
 {
-  predicate_t pred;
-  scope_t&    context;
+public:
+  // Most predicates are built from terms such as "account =~ /Expenses/",
+  // whose value is the same for every posting in a given account (or with
+  // a given payee or date).  After compiling the predicate, such terms are
+  // replaced by lookups into a table of results keyed on that one property,
+  // so that the term is only evaluated once per distinct key.
+  class memoized_term_t
+  {
+  public:
+    enum kind_t {
+      ACCOUNT_TERM,
+      PAYEE_TERM,
+      DATE_TERM
+    };
+
+  private:
+    memoized_term_t();
+
+    kind_t           kind;
+    expr_t::ptr_op_t term;
+
+    typedef std::unordered_map<const account_t *, bool> account_results_map;
+    typedef std::unordered_map<string, bool>            payee_results_map;
+    typedef std::unordered_map<long, bool>              date_results_map;
+
+    account_results_map account_results;
+    payee_results_map   payee_results;
+    date_results_map    date_results;
+
+  public:
+    memoized_term_t(kind_t _kind, expr_t::ptr_op_t _term)
+      : kind(_kind), term(_term) {
+      TRACE_CTOR(memoized_term_t, "kind_t, expr_t::ptr_op_t");
+    }
+    ~memoized_term_t() {
+      TRACE_DTOR(memoized_term_t);
+    }
+
+    value_t calc(call_scope_t& args);
+
+    void clear() {
+      account_results.clear();
+      payee_results.clear();
+      date_results.clear();
+    }
+  };
+
+  typedef std::list<shared_ptr<memoized_term_t> > memoized_terms_list;
+
+  // Compile PRED in SCOPE and memoize its terms, adding them to TERMS.
+  static void memoize_predicate(predicate_t&         pred,
+                                scope_t&             scope,
+                                memoized_terms_list& terms);
+
+private:
+  predicate_t         pred;
+  scope_t&            context;
+  bool                memoized;
+  memoized_terms_list memoized_terms;
 
   filter_posts();
 
+  void memoize_terms(scope_t& scope);
+
 public:
   filter_posts(post_handler_ptr   handler,
                const predicate_t& predicate,
                scope_t&           _context)
-    : item_handler<post_t>(handler), pred(predicate), context(_context) {
+    : item_handler<post_t>(handler), pred(predicate), context(_context),
+      memoized(false) {
     TRACE_CTOR(filter_posts, "post_handler_ptr, predicate_t, scope_t&");
   }
   virtual ~filter_posts() {
@@ -341,6 +427,8 @@ public:
 
   virtual void operator()(post_t& post) {
     bind_scope_t bound_scope(context, post);
+    if (! memoized)
+      memoize_terms(bound_scope);
     if (pred(bound_scope)) {
       post.xdata().add_flags(POST_EXT_MATCHES);
       (*handler)(post);
@@ -349,6 +437,8 @@ public:
 
   virtual void clear() {
     pred.mark_uncompiled();
+    foreach (shared_ptr<memoized_term_t>& term, memoized_terms)
+      term->clear();
     item_handler<post_t>::clear();
   }
 };
@@ -571,6 +661,60 @@ public:
   }
 };
 
+// register_posts does the work of calc_posts, display_filter_posts and the
+// filter_posts for --limit and --display in a single handler.  The chain
+// builder uses it in place of those handlers when a posting report needs
+// nothing else between them; the result must be the same either way.
+class register_posts : public item_handler<post_t>
+{
+  report_t&   report;
+  expr_t&     amount_expr;
+  expr_t&     display_amount_expr;
+  predicate_t limit_predicate;
+  predicate_t display_predicate;
+  bool        memoized;
+  post_t *    last_post;
+
+  filter_posts::memoized_terms_list memoized_terms;
+
+  register_posts();
+
+public:
+  register_posts(post_handler_ptr   handler,
+                 report_t&          _report,
+                 const predicate_t& _display_predicate);
+
+  virtual ~register_posts() {
+    TRACE_DTOR(register_posts);
+  }
+
+  // True if REPORT's options leave nothing for the other posting handlers
+  // to do, so that register_posts can stand in for the whole chain.
+  static bool applicable(report_t& report);
+
+  // Take over the filtering of the filter_posts that chain_pre_post_handlers
+  // would otherwise put in front of this handler.
+  void set_limit_predicate(const predicate_t& predicate) {
+    limit_predicate = predicate;
+    memoized = false;
+  }
+
+  virtual void operator()(post_t& post);
+
+  virtual void clear() {
+    last_post = NULL;
+    amount_expr.mark_uncompiled();
+    display_amount_expr.mark_uncompiled();
+
+    limit_predicate.mark_uncompiled();
+    display_predicate.mark_uncompiled();
+    foreach (shared_ptr<filter_posts::memoized_term_t>& term, memoized_terms)
+      term->clear();
+
+    item_handler<post_t>::clear();
+  }
+};
+
 class changed_value_posts : public item_handler<post_t>
 {
   // This filter requires that calc_posts be used at some point
@@ -673,12 +817,16 @@ protected:
   typedef std::map<string, acct_value_t>  values_map;
   typedef std::pair<string, acct_value_t> values_pair;
 
+  typedef std::unordered_map<account_t *, values_map::iterator>
+    values_by_account_map;
+
 protected:
-  expr_t&              amount_expr;
-  values_map           values;
-  optional<string>     date_format;
-  temporaries_t        temps;
-  std::deque<post_t *> component_posts;
+  expr_t&               amount_expr;
+  values_map            values;
+  values_by_account_map values_by_account;
+  optional<string>      date_format;
+  temporaries_t         temps;
+  std::deque<post_t *>  component_posts;
 
 public:
   subtotal_posts(post_handler_ptr handler, expr_t& _amount_expr,
@@ -696,6 +844,11 @@ public:
   void report_subtotal(const char * spec_fmt = NULL,
                        const optional<date_interval_t>& interval = none);
 
+  void clear_values() {
+    values.clear();
+    values_by_account.clear();
+  }
+
   virtual void flush() {
     if (values.size() > 0)
       report_subtotal();
@@ -705,7 +858,7 @@ public:
 
   virtual void clear() {
     amount_expr.mark_uncompiled();
-    values.clear();
+    clear_values();
     temps.clear();
     component_posts.clear();
 
@@ -720,6 +873,9 @@ class interval_posts : public subtotal_posts
   account_t *     empty_account;
   bool            exact_periods;
   bool            generate_empty_posts;
+  bool            presorted;
+  bool            started;
+  bool            saw_posts;
 
   std::deque<post_t *> all_posts;
 
@@ -731,13 +887,15 @@ public:
                  expr_t&                amount_expr,
                  const date_interval_t& _interval,
                  bool                   _exact_periods        = false,
-                 bool                   _generate_empty_posts = false)
+                 bool                   _generate_empty_posts = false,
+                 bool                   _presorted            = false)
     : subtotal_posts(_handler, amount_expr), start_interval(_interval),
       interval(start_interval), exact_periods(_exact_periods),
-      generate_empty_posts(_generate_empty_posts) {
+      generate_empty_posts(_generate_empty_posts), presorted(_presorted),
+      started(false), saw_posts(false) {
     create_accounts();
     TRACE_CTOR(interval_posts,
-               "post_handler_ptr, expr_t&, date_interval_t, bool, bool");
+               "post_handler_ptr, expr_t&, date_interval_t, bool, bool, bool");
   }
   virtual ~interval_posts() throw() {
     TRACE_DTOR(interval_posts);
@@ -748,6 +906,7 @@ public:
   }
 
   void report_subtotal(const date_interval_t& ival);
+  void add_to_period(post_t& post);
 
 #if DEBUG_ON
   void debug_interval(const date_interval_t& ival) {
@@ -768,6 +927,9 @@ public:
 
   virtual void clear() {
     interval  = start_interval;
+    started   = false;
+    saw_posts = false;
+    all_posts.clear();
 
     subtotal_posts::clear();
     create_accounts();
@@ -981,6 +1143,20 @@ class forecast_posts : public generate_posts
   scope_t&          context;
   const std::size_t forecast_years;
 
+  typedef std::pair<std::size_t, pending_posts_list::iterator>
+    pending_posts_heap_entry;
+
+  struct pending_post_is_later {
+    bool operator()(const pending_posts_heap_entry& left,
+                    const pending_posts_heap_entry& right) const {
+      const date_t& left_start(*(*left.second).first.start);
+      const date_t& right_start(*(*right.second).first.start);
+      if (left_start != right_start)
+        return left_start > right_start;
+      return left.first > right.first;
+    }
+  };
+
  public:
   forecast_posts(post_handler_ptr   handler,
                  const predicate_t& predicate,
@@ -1046,7 +1222,10 @@ public:
     : item_handler<account_t>(handler), pred(_pred), context(_context) {
     TRACE_CTOR(pass_down_accounts, "acct_handler_ptr, accounts_iterator, ...");
 
-    while (account_t * account = *iter++) {
+    // Advance with the prefix form: the postfix form copies the iterator,
+    // and a sorted iterator carries every pending account with it.
+    while (account_t * account = *iter) {
+      ++iter;
       if (! pred) {
         item_handler<account_t>::operator()(*account);
       } else {
@@ -69,6 +69,47 @@ generate_posts_iterator::generate_posts_iterator
   generate_date(next_aux_date_buf);
   next_aux_date = parse_date(next_aux_date_buf.str());
 
+  // Generate and parse every transaction up front.  Reading the journal
+  // clears all xdata, so it cannot be done while the postings of earlier
+  // transactions are still flowing through the report chain.
+  xacts_i = xacts_end = session.journal->xacts.end();
+
+  if (quantity > 0) {
+    std::ostringstream buf;
+    for (std::size_t i = 0; i < quantity; i++)
+      generate_xact(buf);
+
+    DEBUG("generate.post", "The posts we intend to parse:\n" << buf.str());
+
+    std::size_t existing = session.journal->xacts.size();
+
+    try {
+      shared_ptr<std::istringstream> in(new std::istringstream(buf.str()));
+
+      parse_context_stack_t parsing_context;
+      parsing_context.push(in);
+      parsing_context.get_current().journal = session.journal.get();
+      parsing_context.get_current().scope   = &session;
+
+      session.journal->read(parsing_context);
+    }
+    catch (std::exception&) {
+      add_error_context(_f("While parsing generated transactions (seed %1%):")
+                        % seed);
+      throw;
+    }
+    catch (int) {
+      add_error_context(_f("While parsing generated transactions (seed %1%):")
+                        % seed);
+      throw;
+    }
+
+    xacts_i = session.journal->xacts.begin();
+    std::advance(xacts_i, existing);
+  }
+
+  increment();
+
   TRACE_CTOR(generate_posts_iterator, "bool");
 }
 
@@ -351,40 +392,10 @@ void generate_posts_iterator::increment()
 {
   post_t * post = *posts++;
 
-  if (post == NULL && quantity > 0) {
-    std::ostringstream buf;
-    generate_xact(buf);
-
-    DEBUG("generate.post", "The post we intend to parse:\n" << buf.str());
-
-    try {
-      shared_ptr<std::istringstream> in(new std::istringstream(buf.str()));
-
-      parse_context_stack_t parsing_context;
-      parsing_context.push(in);
-      parsing_context.get_current().journal = session.journal.get();
-      parsing_context.get_current().scope   = &session;
-
-      if (session.journal->read(parsing_context) != 0) {
-        VERIFY(session.journal->xacts.back()->valid());
-        posts.reset(*session.journal->xacts.back());
-        post = *posts++;
-      }
-    }
-    catch (std::exception&) {
-      add_error_context(_f("While parsing generated transaction (seed %1%):")
-                        % seed);
-      add_error_context(buf.str());
-      throw;
-    }
-    catch (int) {
-      add_error_context(_f("While parsing generated transaction (seed %1%):")
-                        % seed);
-      add_error_context(buf.str());
-      throw;
-    }
-
-    quantity--;
+  while (post == NULL && xacts_i != xacts_end) {
+    VERIFY((*xacts_i)->valid());
+    posts.reset(**xacts_i++);
+    post = *posts++;
   }
 
   m_node = post;
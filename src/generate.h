@@ -94,7 +94,9 @@ class generate_posts_iterator
   uniform_real<>   pos_number_range;
   real_generator_t pos_number_gen;
 
-  xact_posts_iterator posts;
+  xacts_list::iterator xacts_i;
+  xacts_list::iterator xacts_end;
+  xact_posts_iterator  posts;
 
 public:
   generate_posts_iterator(session_t&   _session,
@@ -260,6 +260,12 @@ void global_scope_t::execute_command(strings_list args, bool at_repl)
   INFO_START(command, "Finished executing command");
   command(command_args);
   INFO_FINISH(command);
+
+  if (HANDLED(profile)) {
+    static_cast<std::ostream&>(report().output_stream).flush();
+    report_profile(std::cerr);
+    clear_profile();
+  }
 }
 
 int global_scope_t::execute_command_wrapper(strings_list args, bool at_repl)
@@ -293,6 +299,7 @@ void global_scope_t::report_options(report_t& report, std::ostream& out)
   HANDLER(args_only).report(out);
   HANDLER(debug_).report(out);
   HANDLER(init_file_).report(out);
+  HANDLER(profile).report(out);
   HANDLER(script_).report(out);
   HANDLER(trace_).report(out);
   HANDLER(verbose).report(out);
@@ -326,6 +333,9 @@ option_t<global_scope_t> * global_scope_t::lookup_option(const char * p)
   case 'o':
     OPT(options);
     break;
+  case 'p':
+    OPT(profile);
+    break;
   case 's':
     OPT(script_);
     break;
@@ -40,6 +40,7 @@
 
 #include "option.h"
 #include "report.h"
+#include "profile.h"
 
 namespace ledger {
 
@@ -158,6 +159,7 @@ See LICENSE file included with the distribution for details and disclaimer.");
    });
 
   OPTION(global_scope_t, options);
+  OPTION_(global_scope_t, profile, DO() { profile_enabled = true; });
   OPTION(global_scope_t, script_);
   OPTION(global_scope_t, trace_);
   OPTION(global_scope_t, verbose);
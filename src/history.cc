@@ -135,6 +135,7 @@ commodity_history_t::~commodity_history_t()
 
 void commodity_history_t::add_commodity(commodity_t& comm)
 {
+  std::lock_guard<std::recursive_mutex> guard(mutex);
   p_impl->add_commodity(comm);
 }
 
@@ -142,6 +143,7 @@ void commodity_history_t::add_price(const commodity_t& source,
                                     const datetime_t&  when,
                                     const amount_t&    price)
 {
+  std::lock_guard<std::recursive_mutex> guard(mutex);
   p_impl->add_price(source, when, price);
 }
 
@@ -149,6 +151,7 @@ void commodity_history_t::remove_price(const commodity_t& source,
                                        const commodity_t& target,
                                        const datetime_t&  date)
 {
+  std::lock_guard<std::recursive_mutex> guard(mutex);
   p_impl->remove_price(source, target, date);
 }
 
@@ -159,6 +162,7 @@ void commodity_history_t::map_prices(
   const datetime_t&  _oldest,
   bool               bidirectionally)
 {
+  std::lock_guard<std::recursive_mutex> guard(mutex);
   p_impl->map_prices(fn, source, moment, _oldest, bidirectionally);
 }
 
@@ -167,6 +171,7 @@ commodity_history_t::find_price(const commodity_t& source,
                                 const datetime_t&  moment,
                                 const datetime_t&  oldest)
 {
+  std::lock_guard<std::recursive_mutex> guard(mutex);
   return p_impl->find_price(source, moment, oldest);
 }
 
@@ -176,12 +181,14 @@ commodity_history_t::find_price(const commodity_t& source,
                                 const datetime_t&  moment,
                                 const datetime_t&  oldest)
 {
+  std::lock_guard<std::recursive_mutex> guard(mutex);
   return p_impl->find_price(source, target, moment, oldest);
 }
 
 void commodity_history_t::print_map(std::ostream& out,
                                     const datetime_t& moment)
 {
+  std::lock_guard<std::recursive_mutex> guard(mutex);
   p_impl->print_map(out, moment);
 }
 
@@ -58,6 +58,11 @@ class commodity_history_t : public noncopyable
 {
   unique_ptr<commodity_history_impl_t> p_impl;
 
+  // Searches record their edge weights in the graph itself, so even
+  // lookups must hold the lock.  It is recursive because map_prices may
+  // be handed a function that looks up other prices.
+  std::recursive_mutex mutex;
+
 public:
   commodity_history_t();
 
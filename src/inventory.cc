@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2003-2018, John Wiegley.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * - Neither the name of New Artisans LLC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <system.hh>
+
+#include "inventory.h"
+#include "commodity.h"
+#include "annotate.h"
+#include "pool.h"
+
+namespace ledger {
+
+namespace {
+  void add_or_set(amount_t& total, const amount_t& amt)
+  {
+    if (total.is_null())
+      total = amt;
+    else
+      total += amt;
+  }
+
+  amount_t bare_amount(const amount_t& amt)
+  {
+    amount_t bare(amt);
+    if (amt.has_annotation())
+      bare.set_commodity(amt.commodity().referent());
+    return bare;
+  }
+
+  amount_t lot_cost(const annotated_commodity_t& lot, const amount_t& bare)
+  {
+    amount_t cost(*lot.details.price);
+    cost *= bare;
+    return cost;
+  }
+}
+
+bool inventory_t::lot_less_t::operator()
+  (const annotated_commodity_t * left,
+   const annotated_commodity_t * right) const
+{
+  const annotation_t& lhs(left->details);
+  const annotation_t& rhs(right->details);
+
+  if (! lhs.date && rhs.date) return true;
+  if (lhs.date && ! rhs.date) return false;
+  if (lhs.date && *lhs.date != *rhs.date)
+    return *lhs.date < *rhs.date;
+
+  if (lhs < rhs) return true;
+  if (rhs < lhs) return false;
+
+  // The pool keeps one commodity for each distinct annotation, so this
+  // only orders lots whose annotations compare alike.
+  return left < right;
+}
+
+inventory_t& inventory_t::operator+=(const amount_t& amt)
+{
+  if (amt.is_null())
+    throw_(inventory_error,
+           _("Cannot add an uninitialized amount to an inventory"));
+
+  if (amt.is_realzero())
+    return *this;
+
+  const amount_t bare(bare_amount(amt));
+  holding_t&     holding(holdings[&bare.commodity()]);
+
+  add_or_set(holding.quantity, bare);
+
+  if (! amt.has_annotation()) {
+    add_or_set(holding.unannotated, bare);
+  } else {
+    const annotated_commodity_t&
+      lot_comm(as_annotated_commodity(amt.commodity()));
+
+    std::pair<lots_map::iterator, bool> result =
+      holding.lots.insert(lots_map::value_type(&lot_comm, amt));
+    if (! result.second) {
+      result.first->second += amt;
+      if (result.first->second.is_realzero()) {
+        holding.lots.erase(result.first);
+        if (lot_comm.details.price)
+          holding.priced_lots--;
+      }
+    }
+    else if (lot_comm.details.price) {
+      holding.priced_lots++;
+    }
+
+    if (lot_comm.details.price)
+      holding.basis += lot_cost(lot_comm, bare);
+  }
+
+  if (holding.lots.empty() && holding.quantity.is_realzero() &&
+      (holding.unannotated.is_null() || holding.unannotated.is_realzero()))
+    holdings.erase(&bare.commodity());
+
+  return *this;
+}
+
+inventory_t& inventory_t::operator+=(const balance_t& bal)
+{
+  foreach (const balance_t::amounts_map::value_type& pair, bal.amounts)
+    *this += pair.second;
+  return *this;
+}
+
+balance_t inventory_t::relieve(const amount_t& amt, relief_order_t order)
+{
+  if (amt.is_null())
+    throw_(inventory_error,
+           _("Cannot relieve an uninitialized amount from an inventory"));
+
+  const amount_t bare(bare_amount(amt).abs());
+
+  holdings_map::iterator h = holdings.find(&bare.commodity());
+  if (h == holdings.end())
+    throw_(inventory_error,
+           _f("Cannot relieve %1%: no lots of it are held") % bare);
+
+  holding_t& holding(h->second);
+
+  // Find the lots to take from, and how much of each, before changing
+  // anything, so that a failed relief leaves the inventory as it was.
+  typedef std::pair<lots_map::iterator, amount_t> taking_t;
+  std::vector<taking_t> takings;
+  amount_t              remaining(bare);
+
+  lots_map::iterator i, end;
+  if (order == RELIEVE_FIFO) {
+    i   = holding.lots.begin();
+    end = holding.lots.end();
+  } else {
+    i   = holding.lots.end();
+    end = holding.lots.begin();
+  }
+  while (! remaining.is_realzero() && i != end) {
+    lots_map::iterator lot = order == RELIEVE_FIFO ? i++ : --i;
+    if (lot->second.sign() <= 0)
+      continue;
+
+    amount_t taken(bare_amount(lot->second));
+    if (taken > remaining)
+      taken = remaining;
+    remaining -= taken;
+    takings.push_back(taking_t(lot, taken));
+  }
+
+  if (! remaining.is_realzero())
+    throw_(inventory_error,
+           _f("Cannot relieve %1%: only %2% is held in lots")
+           % bare % (bare - remaining));
+
+  balance_t relieved;
+  foreach (taking_t& taking, takings) {
+    const annotated_commodity_t& lot_comm(*taking.first->first);
+
+    if (lot_comm.details.price) {
+      amount_t cost(lot_cost(lot_comm, taking.second));
+      holding.basis -= cost;
+      relieved      += cost;
+    }
+
+    amount_t& lot(taking.first->second);
+    amount_t  taken(taking.second);
+    taken.set_commodity(lot.commodity());
+    lot -= taken;
+    if (lot.is_realzero()) {
+      holding.lots.erase(taking.first);
+      if (lot_comm.details.price)
+        holding.priced_lots--;
+    }
+  }
+  holding.quantity -= bare;
+
+  if (holding.lots.empty() && holding.quantity.is_realzero() &&
+      (holding.unannotated.is_null() || holding.unannotated.is_realzero()))
+    holdings.erase(h);
+
+  return relieved;
+}
+
+const inventory_t::holding_t *
+inventory_t::find_holding(const commodity_t& comm) const
+{
+  holdings_map::const_iterator i =
+    holdings.find(comm.has_annotation() ? &comm.referent() : &comm);
+  if (i == holdings.end())
+    return NULL;
+  return &i->second;
+}
+
+amount_t inventory_t::quantity(const commodity_t& comm) const
+{
+  if (const holding_t * holding = find_holding(comm))
+    return holding->quantity;
+  return amount_t(0L);
+}
+
+balance_t inventory_t::cost_basis(const commodity_t& comm) const
+{
+  if (const holding_t * holding = find_holding(comm))
+    return holding->basis;
+  return balance_t();
+}
+
+balance_t inventory_t::to_balance() const
+{
+  balance_t result;
+  foreach (const holdings_map::value_type& pair, holdings) {
+    if (! pair.second.unannotated.is_null())
+      result += pair.second.unannotated;
+    foreach (const lots_map::value_type& lot, pair.second.lots)
+      result += lot.second;
+  }
+  return result;
+}
+
+balance_t inventory_t::average_lot_prices() const
+{
+  balance_t result;
+
+  foreach (const holdings_map::value_type& pair, holdings) {
+    const holding_t& holding(pair.second);
+
+    amount_t amt(holding.quantity);
+    if (amt.is_realzero())
+      continue;
+
+    annotation_t details;
+    if (holding.priced_lots > 0) {
+      amount_t cost;
+      foreach (const balance_t::amounts_map::value_type& part,
+               holding.basis.amounts)
+        add_or_set(cost, part.second);
+      details.price = cost.is_null() ? amount_t(0L) : cost;
+      *details.price /= amt;
+    }
+
+    // Undated lots are ordered first, so the earliest date is that of
+    // the first dated lot.
+    foreach (const lots_map::value_type& lot, holding.lots) {
+      if (lot.first->details.date) {
+        details.date = *lot.first->details.date;
+        break;
+      }
+    }
+
+    amt.set_commodity(*commodity_pool_t::current_pool->find_or_create
+                      (amt.commodity(), details));
+    result += amt;
+  }
+
+  return result;
+}
+
+bool inventory_t::valid() const
+{
+  foreach (const holdings_map::value_type& pair, holdings) {
+    const holding_t& holding(pair.second);
+    if (! holding.quantity.valid() || holding.priced_lots > holding.lots.size()) {
+      DEBUG("ledger.validate", "inventory_t: holding not valid");
+      return false;
+    }
+    foreach (const lots_map::value_type& lot, holding.lots)
+      if (! lot.second.valid() ||
+          &lot.second.commodity() != lot.first) {
+        DEBUG("ledger.validate", "inventory_t: lot not valid");
+        return false;
+      }
+  }
+  return true;
+}
+
+} // namespace ledger
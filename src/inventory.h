@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2003-2018, John Wiegley.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * - Neither the name of New Artisans LLC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @addtogroup math
+ */
+
+/**
+ * @file   inventory.h
+ * @author John Wiegley
+ *
+ * @ingroup math
+ *
+ * @brief  Open lots held of each commodity, in acquisition order
+ *
+ * A balance_t keeps every lot of a commodity as a separate annotated
+ * commodity, so asking how much of a commodity is held, or at what cost,
+ * means visiting every lot.  An inventory_t keeps the lots of each
+ * commodity ordered by acquisition date and price, along with running
+ * totals of their quantity and cost, so that such questions are answered
+ * without a walk, and lots can be relieved first-in or last-in first.
+ */
+#ifndef _INVENTORY_H
+#define _INVENTORY_H
+
+#include "balance.h"
+
+namespace ledger {
+
+class annotated_commodity_t;
+
+DECLARE_EXCEPTION(inventory_error, std::runtime_error);
+
+/**
+ * @class inventory_t
+ *
+ * @brief The lots of one or more commodities held together.
+ *
+ * Adding an annotated amount adds to the lot it names, and subtracting
+ * one relieves that specific lot; both take logarithmic time in the
+ * number of lots held of its commodity.  Amounts without annotations
+ * are held apart from any lot.
+ */
+class inventory_t
+{
+public:
+  /**
+   * Lots are ordered by acquisition date, undated lots first, and then
+   * as annotation_t orders them, which compares price before tag.
+   */
+  struct lot_less_t
+  {
+    bool operator()(const annotated_commodity_t * left,
+                    const annotated_commodity_t * right) const;
+  };
+
+  typedef std::map<const annotated_commodity_t *, amount_t, lot_less_t>
+    lots_map;
+
+  struct holding_t
+  {
+    amount_t    quantity;     // of the bare commodity, over all lots
+    amount_t    unannotated;  // the part of quantity not in any lot
+    balance_t   basis;        // the cost of the lots which have a price
+    std::size_t priced_lots;
+    lots_map    lots;
+
+    holding_t() : priced_lots(0) {}
+  };
+
+  typedef std::unordered_map<const commodity_t *, holding_t> holdings_map;
+
+  enum relief_order_t {
+    RELIEVE_FIFO,
+    RELIEVE_LIFO
+  };
+
+  holdings_map holdings;
+
+  inventory_t() {
+    TRACE_CTOR(inventory_t, "");
+  }
+  inventory_t(const inventory_t& inv) : holdings(inv.holdings) {
+    TRACE_CTOR(inventory_t, "copy");
+  }
+  explicit inventory_t(const balance_t& bal) {
+    TRACE_CTOR(inventory_t, "const balance_t&");
+    *this += bal;
+  }
+  ~inventory_t() {
+    TRACE_DTOR(inventory_t);
+  }
+
+  inventory_t& operator=(const inventory_t& inv) {
+    if (this != &inv)
+      holdings = inv.holdings;
+    return *this;
+  }
+
+  inventory_t& operator+=(const amount_t& amt);
+  inventory_t& operator+=(const balance_t& bal);
+  inventory_t& operator-=(const amount_t& amt) {
+    return *this += amt.negated();
+  }
+
+  /**
+   * relieve(amt, order) removes amt's worth of its commodity from the
+   * lots held, oldest first for RELIEVE_FIFO and newest first for
+   * RELIEVE_LIFO, and returns the cost basis of what was removed.  Only
+   * lots with a positive quantity are relieved.  If they do not hold
+   * enough, inventory_error is thrown and the inventory is unchanged.
+   * To relieve one specific lot, subtract its annotated amount instead.
+   */
+  balance_t relieve(const amount_t& amt, relief_order_t order = RELIEVE_FIFO);
+
+  /**
+   * quantity(comm) returns the total held of comm's bare commodity, and
+   * cost_basis(comm) the sum of price times quantity over those of its
+   * lots that have a price.  Both take constant time.
+   */
+  amount_t  quantity(const commodity_t& comm) const;
+  balance_t cost_basis(const commodity_t& comm) const;
+
+  const holding_t * find_holding(const commodity_t& comm) const;
+
+  /**
+   * to_balance() returns every lot and unannotated amount held as a
+   * balance_t, while average_lot_prices() returns each commodity once,
+   * annotated with its average lot price and earliest lot date.
+   */
+  balance_t to_balance() const;
+  balance_t average_lot_prices() const;
+
+  bool is_empty() const {
+    return holdings.empty();
+  }
+
+  bool valid() const;
+};
+
+} // namespace ledger
+
+#endif // _INVENTORY_H
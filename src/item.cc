@@ -37,31 +37,98 @@ namespace ledger {
 
 bool item_t::use_aux_date = false;
 
-bool item_t::has_tag(const string& tag, bool) const
+namespace {
+  struct tag_table_t
+  {
+    std::deque<string>                          names;
+    std::vector<item_t::tag_id_t>               keys;
+    std::unordered_map<string, item_t::tag_id_t> ids;
+  };
+
+  tag_table_t& tag_table()
+  {
+    static tag_table_t table;
+    return table;
+  }
+}
+
+item_t::tag_id_t item_t::intern_tag(const string& name)
 {
-  DEBUG("item.meta", "Checking if item has tag: " << tag);
+  tag_table_t& table(tag_table());
+
+  std::unordered_map<string, tag_id_t>::const_iterator i =
+    table.ids.find(name);
+  if (i != table.ids.end())
+    return (*i).second;
+
+  tag_id_t id = static_cast<tag_id_t>(table.names.size());
+  table.names.push_back(name);
+  table.keys.push_back(id);
+  table.ids.insert(std::make_pair(name, id));
+
+  // Tag names are compared like boost::algorithm::ilexicographical_compare
+  // would, which only folds the case of ASCII letters.
+  string lower(name);
+  foreach (char& ch, lower)
+    ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+  if (lower != name) {
+    tag_id_t key = intern_tag(lower);
+    table.keys[id] = key;
+  }
+
+  return id;
+}
+
+const string& item_t::tag_name(tag_id_t id)
+{
+  assert(id < tag_table().names.size());
+  return tag_table().names[id];
+}
+
+item_t::tag_id_t item_t::tag_key(tag_id_t id)
+{
+  assert(id < tag_table().keys.size());
+  return tag_table().keys[id];
+}
+
+const item_t::tag_data_t * item_t::find_tag(const string& tag) const
+{
+  if (deferred_tags_mention(tag))
+    parse_deferred_tags();
   if (! metadata) {
     DEBUG("item.meta", "Item has no metadata at all");
-    return false;
+    return NULL;
   }
-  string_map::const_iterator i = metadata->find(tag);
+
+  tag_id_t key = tag_key(intern_tag(tag));
+  foreach (const metadata_t::value_type& data, *metadata)
+    if (tag_key(data.first) == key)
+      return &data.second;
+  return NULL;
+}
+
+bool item_t::has_tag(const string& tag, bool) const
+{
+  DEBUG("item.meta", "Checking if item has tag: " << tag);
+  const tag_data_t * data = find_tag(tag);
 #if DEBUG_ON
   if (SHOW_DEBUG("item.meta")) {
-    if (i == metadata->end())
+    if (! data)
       DEBUG("item.meta", "Item does not have this tag");
     else
       DEBUG("item.meta", "Item has the tag!");
   }
 #endif
-  return i != metadata->end();
+  return data != NULL;
 }
 
 bool item_t::has_tag(const mask_t& tag_mask,
                      const optional<mask_t>& value_mask, bool) const
 {
+  parse_deferred_tags();
   if (metadata) {
-    foreach (const string_map::value_type& data, *metadata) {
-      if (tag_mask.match(data.first)) {
+    foreach (const metadata_t::value_type& data, *metadata) {
+      if (tag_mask.match(tag_name(data.first))) {
         if (! value_mask)
           return true;
         else if (data.second.first)
@@ -75,13 +142,9 @@ bool item_t::has_tag(const mask_t& tag_mask,
 optional<value_t> item_t::get_tag(const string& tag, bool) const
 {
   DEBUG("item.meta", "Getting item tag: " << tag);
-  if (metadata) {
-    DEBUG("item.meta", "Item has metadata");
-    string_map::const_iterator i = metadata->find(tag);
-    if (i != metadata->end()) {
-      DEBUG("item.meta", "Found the item!");
-      return (*i).second.first;
-    }
+  if (const tag_data_t * data = find_tag(tag)) {
+    DEBUG("item.meta", "Found the item!");
+    return data->first;
   }
   return none;
 }
@@ -90,9 +153,10 @@ optional<value_t> item_t::get_tag(const mask_t& tag_mask,
                                   const optional<mask_t>& value_mask,
                                   bool) const
 {
+  parse_deferred_tags();
   if (metadata) {
-    foreach (const string_map::value_type& data, *metadata) {
-      if (tag_mask.match(data.first) &&
+    foreach (const metadata_t::value_type& data, *metadata) {
+      if (tag_mask.match(tag_name(data.first)) &&
           (! value_mask ||
            (data.second.first &&
             value_mask->match(data.second.first->to_string())))) {
@@ -103,25 +167,16 @@ optional<value_t> item_t::get_tag(const mask_t& tag_mask,
   return none;
 }
 
-namespace {
-  struct CaseInsensitiveKeyCompare
-    : public std::binary_function<string, string, bool>
-  {
-    bool operator()(const string& s1, const string& s2) const {
-      return boost::algorithm::ilexicographical_compare(s1, s2);
-    }
-  };
-}
-
-item_t::string_map::iterator
+item_t::metadata_t::iterator
 item_t::set_tag(const string&            tag,
                 const optional<value_t>& value,
                 const bool               overwrite_existing)
 {
   assert(! tag.empty());
 
+  parse_deferred_tags();
   if (! metadata)
-    metadata = string_map(CaseInsensitiveKeyCompare());
+    metadata = metadata_t();
 
   DEBUG("item.meta", "Setting tag '" << tag << "' to value '"
         << (value ? *value : string_value("<none>")) << "'");
@@ -131,17 +186,27 @@ item_t::set_tag(const string&            tag,
                (data->is_string() && data->as_string().empty())))
     data = none;
 
-  string_map::iterator i = metadata->find(tag);
-  if (i == metadata->end()) {
-    std::pair<string_map::iterator, bool> result
-      = metadata->insert(string_map::value_type(tag, tag_data_t(data, false)));
-    assert(result.second);
-    return result.first;
-  } else {
-    if (overwrite_existing)
-      (*i).second = tag_data_t(data, false);
-    return i;
+  tag_id_t id  = intern_tag(tag);
+  tag_id_t key = tag_key(id);
+  for (metadata_t::iterator i = metadata->begin();
+       i != metadata->end();
+       i++) {
+    if (tag_key((*i).first) == key) {
+      if (overwrite_existing)
+        (*i).second = tag_data_t(data, false);
+      return i;
+    }
   }
+
+  metadata_t::iterator i =
+    std::lower_bound(metadata->begin(), metadata->end(), tag,
+                     [](const metadata_t::value_type& entry,
+                        const string& name) {
+                       return boost::algorithm::ilexicographical_compare
+                         (tag_name(entry.first), name);
+                     });
+  return metadata->insert(i, metadata_t::value_type(id,
+                                                    tag_data_t(data, false)));
 }
 
 void item_t::parse_tags(const char * p,
@@ -169,6 +234,10 @@ void item_t::parse_tags(const char * p,
     return;
   }
 
+  // Tags from earlier note lines must be set first, or overwriting an
+  // existing tag would go the wrong way.
+  parse_deferred_tags();
+
   scoped_array<char> buf(new char[std::strlen(p) + 1]);
 
   std::strcpy(buf.get(), p);
@@ -185,7 +254,7 @@ void item_t::parse_tags(const char * p,
       for (char * r = std::strtok(q + 1, ":");
            r;
            r = std::strtok(NULL, ":")) {
-        string_map::iterator i = set_tag(r, none, overwrite_existing);
+        metadata_t::iterator i = set_tag(r, none, overwrite_existing);
         (*i).second.second = true;
       }
     }
@@ -197,7 +266,7 @@ void item_t::parse_tags(const char * p,
       }
       tag = string(q, len - index);
 
-      string_map::iterator i;
+      metadata_t::iterator i;
       string field(p + (q - buf.get()) + len);
       trim(field);
       if (by_value) {
@@ -217,14 +286,66 @@ void item_t::append_note(const char * p,
                          scope_t&     scope,
                          bool         overwrite_existing)
 {
+  std::size_t offset = 0;
   if (note) {
     *note += '\n';
+    offset = note->length();
     *note += p;
   } else {
     note = p;
   }
 
-  parse_tags(p, scope, overwrite_existing);
+  parse_note_tags(offset, scope, overwrite_existing);
+}
+
+void item_t::parse_note_tags(std::size_t offset,
+                             scope_t&    scope,
+                             bool        overwrite_existing)
+{
+  const char * p = note->c_str() + offset;
+
+  // A line without colons may give the item's dates, and a tag set with
+  // "::" is an expression to be computed in SCOPE, so only lines of plain
+  // tags can wait until the metadata is asked for.
+  if (std::strchr(p, ':') && ! std::strstr(p, "::"))
+    deferred_tags.push_back(deferred_tags_t(offset, note->length() - offset,
+                                            overwrite_existing));
+  else
+    parse_tags(p, scope, overwrite_existing);
+}
+
+void item_t::parse_deferred_tags() const
+{
+  if (deferred_tags.empty())
+    return;
+
+  assert(note);
+
+  // Set the tags aside first, since parse_tags and set_tag both come
+  // back here before changing the metadata.
+  deferred_tags_list lines;
+  lines.swap(deferred_tags);
+
+  item_t& self(const_cast<item_t&>(*this));
+  foreach (const deferred_tags_t& line, lines)
+    self.item_t::parse_tags(string(*note, line.offset, line.length).c_str(),
+                            self, line.overwrite_existing);
+}
+
+bool item_t::deferred_tags_mention(const string& tag) const
+{
+  // Tag names are compared without regard to case; see set_tag.
+  foreach (const deferred_tags_t& line, deferred_tags) {
+    const char * b = note->c_str() + line.offset;
+    const char * e = b + line.length;
+    if (std::search(b, e, tag.begin(), tag.end(),
+                    [](char x, char y) {
+                      return (std::tolower(static_cast<unsigned char>(x)) ==
+                              std::tolower(static_cast<unsigned char>(y)));
+                    }) != e)
+      return true;
+  }
+  return false;
 }
 
 namespace {
@@ -600,15 +721,15 @@ string item_context(const item_t& item, const string& desc)
   return out.str();
 }
 
-void put_metadata(property_tree::ptree& st, const item_t::string_map& metadata)
+void put_metadata(property_tree::ptree& st, const item_t::metadata_t& metadata)
 {
-  foreach (const item_t::string_map::value_type& pair, metadata) {
+  foreach (const item_t::metadata_t::value_type& pair, metadata) {
     if (pair.second.first) {
       property_tree::ptree& vt(st.add("value", ""));
-      vt.put("<xmlattr>.key", pair.first);
+      vt.put("<xmlattr>.key", item_t::tag_name(pair.first));
       put_value(vt, *pair.second.first);
     } else {
-      st.add("tag", pair.first);
+      st.add("tag", item_t::tag_name(pair.first));
     }
   }
 }
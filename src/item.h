@@ -90,16 +90,42 @@ public:
 
   enum state_t { UNCLEARED = 0, CLEARED, PENDING };
 
+  // Tag names are interned, so that each spelling is stored only once
+  // however many items use it; see intern_tag.
+  typedef uint_least32_t tag_id_t;
+
   typedef std::pair<optional<value_t>, bool> tag_data_t;
-  typedef std::map<string, tag_data_t,
-                   std::function<bool(string, string)> > string_map;
+
+  // An item's tags, kept in the order of their names without regard to
+  // case.  Items seldom have more than a handful, so lookups just scan.
+  typedef std::vector<std::pair<tag_id_t, tag_data_t> > metadata_t;
+
+  // A line of the note whose tags have not been parsed into metadata yet.
+  struct deferred_tags_t
+  {
+    std::size_t offset;
+    std::size_t length;
+    bool        overwrite_existing;
+
+    deferred_tags_t(std::size_t _offset, std::size_t _length,
+                    bool _overwrite_existing)
+      : offset(_offset), length(_length),
+        overwrite_existing(_overwrite_existing) {}
+  };
+
+  typedef std::vector<deferred_tags_t> deferred_tags_list;
 
   state_t              _state;
   optional<date_t>     _date;
   optional<date_t>     _date_aux;
   optional<string>     note;
   optional<position_t> pos;
-  optional<string_map> metadata;
+
+  // Tags in note lines are only parsed when something first asks for the
+  // metadata; anything reading metadata directly must call
+  // parse_deferred_tags() beforehand.
+  mutable optional<metadata_t> metadata;
+  mutable deferred_tags_list   deferred_tags;
 
   item_t(flags_t _flags = ITEM_NORMAL, const optional<string>& _note = none)
     : supports_flags<uint_least16_t>(_flags), _state(UNCLEARED), note(_note)
@@ -117,6 +143,8 @@ public:
 
   virtual void copy_details(const item_t& item)
   {
+    item.parse_deferred_tags();
+
     set_flags(item.flags());
     set_state(item.state());
 
@@ -159,7 +187,7 @@ public:
                                     const optional<mask_t>& value_mask = none,
                                     bool                    inherit    = true) const;
 
-  virtual string_map::iterator
+  virtual metadata_t::iterator
   set_tag(const string&            tag,
           const optional<value_t>& value              = none,
           const bool               overwrite_existing = true);
@@ -171,6 +199,26 @@ public:
                            scope_t&     scope,
                            bool         overwrite_existing = true);
 
+  // Parse the tags of the note line starting at OFFSET, the last one
+  // appended, or defer them if they can be parsed without SCOPE.
+  virtual void parse_note_tags(std::size_t offset,
+                               scope_t&    scope,
+                               bool        overwrite_existing = true);
+
+  void parse_deferred_tags() const;
+  bool deferred_tags_mention(const string& tag) const;
+
+  // The data of the tag named TAG, or NULL if the item does not have it.
+  const tag_data_t * find_tag(const string& tag) const;
+
+  // Return the id of the tag name NAME, adding it if it is new.
+  static tag_id_t      intern_tag(const string& name);
+  static const string& tag_name(tag_id_t id);
+
+  // The id of the lowercase spelling of tag name ID, which is the same
+  // for every name that differs from it only in case.
+  static tag_id_t      tag_key(tag_id_t id);
+
   static bool use_aux_date;
 
   virtual bool has_date() const {
@@ -211,7 +259,7 @@ value_t get_comment(item_t& item);
 void    print_item(std::ostream& out, const item_t& item,
                    const string& prefix = "");
 string  item_context(const item_t& item, const string& desc);
-void    put_metadata(property_tree::ptree& pt, const item_t::string_map& metadata);
+void    put_metadata(property_tree::ptree& pt, const item_t::metadata_t& metadata);
 
 } // namespace ledger
 
@@ -199,9 +199,7 @@ void sorted_accounts_iterator::push_back(account_t& account)
   if (flatten_all) {
     push_all(account, accounts_list.back());
 
-    std::stable_sort(accounts_list.back().begin(),
-                     accounts_list.back().end(),
-                     compare_items<account_t>(sort_cmp, report));
+    sort_by_keys(accounts_list.back());
 
 #if DEBUG_ON
     if (SHOW_DEBUG("account.sorted")) {
@@ -233,8 +231,7 @@ void sorted_accounts_iterator::sort_accounts(account_t& account,
   foreach (accounts_map::value_type& pair, account.accounts)
     deque.push_back(pair.second);
 
-  std::stable_sort(deque.begin(), deque.end(),
-                   compare_items<account_t>(sort_cmp, report));
+  sort_by_keys(deque);
 
 #if DEBUG_ON
   if (SHOW_DEBUG("account.sorted")) {
@@ -244,6 +241,30 @@ void sorted_accounts_iterator::sort_accounts(account_t& account,
 #endif
 }
 
+void sorted_accounts_iterator::sort_by_keys(accounts_deque_t& deque)
+{
+  // Calculate every sort key once up front, so that the sort itself only
+  // compares values instead of looking up xdata on each comparison.
+  typedef std::pair<const std::list<sort_value_t> *, account_t *> keyed_t;
+
+  compare_items<account_t> cmp(sort_cmp, report);
+
+  std::vector<keyed_t> keyed;
+  keyed.reserve(deque.size());
+  foreach (account_t * acct, deque)
+    keyed.push_back(keyed_t(&cmp.sort_values_for(acct), acct));
+
+  std::stable_sort(keyed.begin(), keyed.end(),
+                   [](const keyed_t& left, const keyed_t& right) {
+                     return sort_value_is_less_than(*left.first,
+                                                    *right.first);
+                   });
+
+  accounts_deque_t::iterator i = deque.begin();
+  foreach (const keyed_t& item, keyed)
+    *i++ = item.second;
+}
+
 void sorted_accounts_iterator::increment()
 {
   while (! sorted_accounts_i.empty() &&
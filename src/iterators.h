@@ -229,7 +229,9 @@ public:
     : iterator_facade_base<posts_commodities_iterator, post_t *,
                            boost::forward_traversal_tag>(i),
       journal_posts(i.journal_posts), xacts(i.xacts), posts(i.posts),
-      xact_temps(i.xact_temps), temps(i.temps) {
+      xact_temps(i.xact_temps) {
+    // The temporaries are owned by the original iterator, and the copied
+    // xacts still refer to them, so the copy starts with none of its own
     TRACE_CTOR(posts_commodities_iterator, "copy");
   }
   ~posts_commodities_iterator() throw() {
@@ -322,6 +324,7 @@ private:
   void push_back(account_t& account);
   void push_all(account_t& account, accounts_deque_t& deque);
   void sort_accounts(account_t& account, accounts_deque_t& deque);
+  void sort_by_keys(accounts_deque_t& deque);
 };
 
 } // namespace ledger
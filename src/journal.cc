@@ -39,6 +39,7 @@
 #include "xact.h"
 #include "post.h"
 #include "account.h"
+#include "columns.h"
 
 namespace ledger {
 
@@ -93,6 +94,11 @@ void journal_t::initialize()
   checking_style    = CHECK_NORMAL;
   recursive_aliases = false;
   no_aliases        = false;
+  sorted_by_date     = true;
+  sorted_by_aux_date = true;
+
+  running_totals_built  = false;
+  running_totals_usable = false;
 }
 
 void journal_t::add_account(account_t * acct)
@@ -120,7 +126,9 @@ account_t * journal_t::register_account(const string& name, post_t * post,
 {
   // If there are any account aliases, substitute before creating an account
   // object.
-  account_t * result = expand_aliases(name);
+  account_t * result = NULL;
+  if (! account_aliases.empty())
+    result = expand_aliases(name);
 
   // Create the account object and associate it with the journal; this
   // is registering the account.
@@ -317,10 +325,23 @@ namespace {
     xact_t * xact = context.which() == 1 ? boost::get<xact_t *>(context) : NULL;
     post_t * post = context.which() == 2 ? boost::get<post_t *>(context) : NULL;
 
+    // Only parse the item's tags here if they must be known or a tag
+    // directive has checks for their values; otherwise they can wait
+    // until a report asks for them.
+    if (journal.checking_style != journal_t::CHECK_WARNING &&
+        journal.checking_style != journal_t::CHECK_ERROR &&
+        journal.tag_check_exprs.empty())
+      return;
+
+    if (xact)
+      xact->parse_deferred_tags();
+    else if (post)
+      post->parse_deferred_tags();
+
     if ((xact || post) && xact ? xact->metadata : post->metadata) {
-      foreach (const item_t::string_map::value_type& pair,
+      foreach (const item_t::metadata_t::value_type& pair,
                xact ? *xact->metadata : *post->metadata) {
-        const string& key(pair.first);
+        const string& key(item_t::tag_name(pair.first));
 
         if (optional<value_t> value = pair.second.first)
           journal.register_metadata(key, *value, context);
@@ -350,7 +371,11 @@ bool journal_t::add_xact(xact_t * xact)
 {
   xact->journal = this;
 
-  if (! xact->finalize()) {
+  INFO_START(finalize, "Finalized transactions");
+  bool finalized = xact->finalize();
+  INFO_STOP(finalize);
+
+  if (! finalized) {
     xact->journal = NULL;
     return false;
   }
@@ -421,7 +446,24 @@ bool journal_t::add_xact(xact_t * xact)
     }
   }
 
+  // Note whether the postings are still being seen in date order, so
+  // that reports which group them by period need not sort them first.
+  foreach (post_t * post, xact->posts) {
+    date_t date = post->primary_date();
+    if (is_valid(last_date) && date < last_date)
+      sorted_by_date = false;
+    last_date = date;
+
+    optional<date_t> aux = post->aux_date();
+    date = aux ? *aux : date;
+    if (is_valid(last_aux_date) && date < last_aux_date)
+      sorted_by_aux_date = false;
+    last_aux_date = date;
+  }
+
   xacts.push_back(xact);
+  running_totals_built = false;
+  post_columns.reset();
 
   return true;
 }
@@ -446,6 +488,8 @@ bool journal_t::remove_xact(xact_t * xact)
 
   xacts.erase(i);
   xact->journal = NULL;
+  running_totals_built = false;
+  post_columns.reset();
 
   return true;
 }
@@ -528,6 +572,171 @@ void journal_t::clear_xdata()
   master->clear_xdata();
 }
 
+namespace {
+  typedef std::pair<date_t, post_t *>                      dated_post_t;
+  typedef std::unordered_map<account_t *,
+                             std::vector<dated_post_t> >   dated_posts_map;
+
+  struct dated_post_is_earlier {
+    bool operator()(const dated_post_t& left,
+                    const dated_post_t& right) const {
+      return left.first < right.first;
+    }
+  };
+
+  std::size_t amounts_in(const value_t& value)
+  {
+    if (value.is_balance())
+      return value.as_balance().amounts.size();
+    return value.is_null() ? 0 : 1;
+  }
+
+  void clear_running_totals(account_t& account)
+  {
+    account.running_totals.clear();
+    foreach (accounts_map::value_type& pair, account.accounts)
+      clear_running_totals(*pair.second);
+  }
+
+  // Return the last running total dated before date, if any
+  const account_t::running_total_t *
+  running_total_before(const account_t& account, const date_t& date)
+  {
+    std::vector<account_t::running_total_t>::const_iterator i =
+      std::lower_bound(account.running_totals.begin(),
+                       account.running_totals.end(), date,
+                       [](const account_t::running_total_t& total,
+                          const date_t& when) {
+                         return total.date < when;
+                       });
+    if (i == account.running_totals.begin())
+      return NULL;
+    return &*--i;
+  }
+
+  void apply_account_running_totals(account_t&              account,
+                                    const optional<date_t>& begin,
+                                    const optional<date_t>& end)
+  {
+    foreach (accounts_map::value_type& pair, account.accounts)
+      apply_account_running_totals(*pair.second, begin, end);
+
+    if (account.running_totals.empty())
+      return;
+
+    const account_t::running_total_t * last =
+      end ? running_total_before(account, *end) :
+      &account.running_totals.back();
+    if (! last)
+      return;
+
+    const account_t::running_total_t * first =
+      begin ? running_total_before(account, *begin) : NULL;
+    if (first && first->count == last->count)
+      return;
+
+    account_t::xdata_t::details_t& details(account.xdata().self_details);
+
+    details.total      = last->total;
+    details.real_total = last->real_total;
+    if (first) {
+      if (! first->total.is_null())
+        details.total -= first->total;
+      if (! first->real_total.is_null())
+        details.real_total -= first->real_total;
+    }
+
+    // There are no visited postings left for account_t::amount to add
+    details.last_post = account.posts.size();
+
+    account.xdata().add_flags(ACCOUNT_EXT_VISITED);
+  }
+}
+
+bool journal_t::build_running_totals()
+{
+  clear_running_totals(*master);
+
+  running_totals_built  = true;
+  running_totals_usable = false;
+
+  dated_posts_map posts_by_account;
+  std::size_t     post_count = 0;
+  foreach (xact_t * xact, xacts)
+    foreach (post_t * post, xact->posts) {
+      posts_by_account[post->account].push_back
+        (dated_post_t(post->primary_date(), post));
+      post_count++;
+    }
+
+  // Every day's totals copy the account's balance so far, so an account
+  // that holds many commodities at once, such as one lot per purchase,
+  // would need memory quadratic in its postings.  Give up once the totals
+  // hold more amounts than a small multiple of the postings read.
+  const std::size_t amount_limit = 8 * post_count + 1024;
+  std::size_t       amounts_kept = 0;
+
+  foreach (dated_posts_map::value_type& pair, posts_by_account) {
+    if (! sorted_by_date)
+      std::stable_sort(pair.second.begin(), pair.second.end(),
+                       dated_post_is_earlier());
+
+    std::vector<account_t::running_total_t>& totals(pair.first->running_totals);
+    foreach (dated_post_t& dated, pair.second) {
+      post_t& post(*dated.second);
+
+      if (totals.empty() || totals.back().date != dated.first) {
+        account_t::running_total_t next;
+        if (! totals.empty())
+          next = totals.back();
+        else
+          next.count = 0;
+        next.date = dated.first;
+        totals.push_back(next);
+
+        amounts_kept += amounts_in(next.total) + amounts_in(next.real_total);
+        if (amounts_kept > amount_limit) {
+          DEBUG("journal.running_totals",
+                "Running totals exceed " << amount_limit << " amounts");
+          clear_running_totals(*master);
+          return false;
+        }
+      }
+
+      value_t amount(post.amount.is_null() ? value_t(0L) :
+                     value_t(post.amount));
+      account_t::running_total_t& current(totals.back());
+
+      current.count++;
+      add_or_set_value(current.total, amount);
+      if (! post.has_flags(POST_VIRTUAL))
+        add_or_set_value(current.real_total, amount);
+    }
+  }
+
+  running_totals_usable = true;
+  return true;
+}
+
+bool journal_t::apply_running_totals(const optional<date_t>& begin,
+                                     const optional<date_t>& end)
+{
+  if (! running_totals_built)
+    build_running_totals();
+  if (! running_totals_usable)
+    return false;
+
+  apply_account_running_totals(*master, begin, end);
+  return true;
+}
+
+bool journal_t::apply_post_columns(expr_t& predicate)
+{
+  if (! post_columns)
+    post_columns.reset(new post_columns_t(*this));
+  return post_columns->apply_totals(predicate.get_op());
+}
+
 bool journal_t::valid() const
 {
   if (! master->valid()) {
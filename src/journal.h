@@ -55,10 +55,11 @@ class auto_xact_t;
 class period_xact_t;
 class post_t;
 class account_t;
+class post_columns_t;
 class parse_context_t;
 class parse_context_stack_t;
 
-typedef std::list<xact_t *>              xacts_list;
+typedef std::vector<xact_t *>            xacts_list;
 typedef std::list<auto_xact_t *>         auto_xacts_list;
 typedef std::list<period_xact_t *>       period_xacts_list;
 typedef std::pair<mask_t, string>        payee_alias_mapping_t;
@@ -115,6 +116,13 @@ public:
   bool                   day_break;
   bool                   recursive_aliases;
   bool                   no_aliases;
+  bool                   sorted_by_date;
+  bool                   sorted_by_aux_date;
+  bool                   running_totals_built;
+  bool                   running_totals_usable;
+  unique_ptr<post_columns_t> post_columns;
+  date_t                 last_date;
+  date_t                 last_aux_date;
   payee_alias_mappings_t payee_alias_mappings;
   payee_uuid_mappings_t  payee_uuid_mappings;
   account_mappings_t     account_mappings;
@@ -191,6 +199,11 @@ public:
   bool has_xdata();
   void clear_xdata();
 
+  bool build_running_totals();
+  bool apply_running_totals(const optional<date_t>& begin,
+                            const optional<date_t>& end);
+  bool apply_post_columns(expr_t& predicate);
+
   bool valid() const;
 
 private:
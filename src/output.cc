@@ -339,6 +339,11 @@ void report_tags::flush()
 {
   std::ostream& out(report.output_stream);
 
+  typedef std::map<item_t::tag_id_t, std::size_t>::value_type tag_ids_pair;
+  foreach (tag_ids_pair& entry, tag_ids)
+    tags[item_t::tag_name(entry.first)] += entry.second;
+  tag_ids.clear();
+
   foreach (tags_pair& entry, tags) {
     if (report.HANDLED(count))
       out << entry.second << ' ';
@@ -348,12 +353,17 @@ void report_tags::flush()
 
 void report_tags::gather_metadata(item_t& item)
 {
+  item.parse_deferred_tags();
   if (! item.metadata)
     return;
-  foreach (const item_t::string_map::value_type& data, *item.metadata) {
-    string tag(data.first);
-    if (report.HANDLED(values) && data.second.first)
-      tag += ": " + data.second.first.get().to_string();
+  foreach (const item_t::metadata_t::value_type& data, *item.metadata) {
+    if (! report.HANDLED(values) || ! data.second.first) {
+      tag_ids[data.first]++;
+      continue;
+    }
+
+    string tag(item_t::tag_name(data.first));
+    tag += ": " + data.second.first.get().to_string();
 
     std::map<string, std::size_t>::iterator i = tags.find(tag);
     if (i == tags.end())
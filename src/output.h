@@ -46,6 +46,7 @@
 #include "predicate.h"
 #include "format.h"
 #include "account.h"
+#include "item.h"
 
 namespace ledger {
 
@@ -198,6 +199,10 @@ protected:
 
   std::map<string, std::size_t> tags;
 
+  // Without --values tags are counted by their interned names, and only
+  // turned into strings when the report is flushed.
+  std::map<item_t::tag_id_t, std::size_t> tag_ids;
+
   typedef std::map<string, std::size_t>::value_type tags_pair;
 
 public:
@@ -214,6 +219,7 @@ public:
 
   virtual void clear() {
     tags.clear();
+    tag_ids.clear();
     item_handler<post_t>::clear();
   }
 };
@@ -42,10 +42,45 @@ namespace ledger {
 
 shared_ptr<commodity_pool_t> commodity_pool_t::current_pool;
 
+namespace {
+  template <typename T>
+  inline void hash_combine(std::size_t& seed, const T& value) {
+    seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  }
+}
+
+commodity_pool_t::annotated_key_t::annotated_key_t
+  (const string& _symbol, const annotation_t& _details)
+  : symbol(&_symbol), details(&_details), hash(std::hash<string>()(_symbol))
+{
+  // Only what annotation_t::operator< looks at may go into the hash.
+  // Prices are hashed by their value as a double, so that equal rationals
+  // always hash alike whatever their precision.
+  if (_details.price) {
+    hash_combine(hash, 1);
+    hash_combine(hash, _details.price->commodity().symbol());
+    if (! _details.price->is_null())
+      hash_combine(hash, _details.price->to_double());
+  }
+  if (_details.date) {
+    hash_combine(hash, 2);
+    hash_combine(hash, _details.date->day_number());
+  }
+  if (_details.tag) {
+    hash_combine(hash, 3);
+    hash_combine(hash, *_details.tag);
+  }
+  if (_details.value_expr) {
+    hash_combine(hash, 4);
+    hash_combine(hash, _details.value_expr->text());
+  }
+}
+
 commodity_pool_t::commodity_pool_t()
   : default_commodity(NULL), keep_base(false),
     quote_leeway(86400), get_quotes(false),
-    get_commodity_quote(commodity_quote_from_script)
+    get_commodity_quote(commodity_quote_from_script),
+    last_found(NULL), last_annotated(NULL)
 {
   null_commodity = create("");
   null_commodity->add_flags(COMMODITY_BUILTIN | COMMODITY_NOMARKET);
@@ -60,6 +95,8 @@ commodity_t * commodity_pool_t::create(const string& symbol)
 
   DEBUG("pool.commodities", "Creating base commodity " << symbol);
 
+  std::lock_guard<std::recursive_mutex> guard(mutex);
+
   // Create the "qualified symbol" version of this commodity's symbol
   if (commodity_t::symbol_needs_quotes(symbol)) {
     commodity->qualified_symbol = "\"";
@@ -86,15 +123,27 @@ commodity_t * commodity_pool_t::find(const string& symbol)
 {
   DEBUG("pool.commodities", "Find commodity " << symbol);
 
+  const commodities_map::value_type * last =
+    last_found.load(std::memory_order_acquire);
+  if (last && last->first == symbol)
+    return last->second.get();
+
+  std::lock_guard<std::recursive_mutex> guard(mutex);
+
   commodities_map::const_iterator i = commodities.find(symbol);
-  if (i != commodities.end())
+  if (i != commodities.end()) {
+    last_found.store(&*i, std::memory_order_release);
     return (*i).second.get();
+  }
   return NULL;
 }
 
 commodity_t * commodity_pool_t::find_or_create(const string& symbol)
 {
   DEBUG("pool.commodities", "Find-or-create commodity " << symbol);
+
+  std::lock_guard<std::recursive_mutex> guard(mutex);
+
   if (commodity_t * commodity = find(symbol))
     return commodity;
   return create(symbol);
@@ -102,6 +151,8 @@ commodity_t * commodity_pool_t::find_or_create(const string& symbol)
 
 commodity_t * commodity_pool_t::alias(const string& name, commodity_t& referent)
 {
+  std::lock_guard<std::recursive_mutex> guard(mutex);
+
   commodities_map::const_iterator i = commodities.find(referent.base_symbol());
   assert(i != commodities.end());
 
@@ -130,6 +181,15 @@ commodity_pool_t::find(const string& symbol, const annotation_t& details)
   DEBUG("pool.commodities", "commodity_pool_t::find[ann] "
         << "symbol " << symbol << std::endl << details);
 
+  const annotated_commodities_map::value_type * last =
+    last_annotated.load(std::memory_order_acquire);
+  if (last && *last->first.symbol == symbol &&
+      ! (*last->first.details < details) &&
+      ! (details < *last->first.details))
+    return last->second.get();
+
+  std::lock_guard<std::recursive_mutex> guard(mutex);
+
   annotated_commodities_map::const_iterator i =
     annotated_commodities.find
     (annotated_commodities_map::key_type(symbol, details));
@@ -137,6 +197,7 @@ commodity_pool_t::find(const string& symbol, const annotation_t& details)
     DEBUG("pool.commodities", "commodity_pool_t::find[ann] found "
           << "symbol " << (*i).second->base_symbol() << std::endl
           << as_annotated_commodity(*(*i).second.get()).details);
+    last_annotated.store(&*i, std::memory_order_release);
     return (*i).second.get();
   } else {
     return NULL;
@@ -150,6 +211,8 @@ commodity_pool_t::find_or_create(const string& symbol,
   DEBUG("pool.commodities", "commodity_pool_t::find_or_create[ann] "
         << "symbol " << symbol << std::endl << details);
 
+  std::lock_guard<std::recursive_mutex> guard(mutex);
+
   if (details) {
     if (commodity_t * ann_comm = find(symbol, details)) {
       assert(ann_comm->annotated && as_annotated_commodity(*ann_comm).details);
@@ -168,8 +231,10 @@ commodity_pool_t::find_or_create(commodity_t& comm, const annotation_t& details)
   DEBUG("pool.commodities", "commodity_pool_t::find_or_create[ann:comm] "
         << "symbol " << comm.base_symbol() << std::endl << details);
 
+  std::lock_guard<std::recursive_mutex> guard(mutex);
+
   if (details) {
-    if (commodity_t * ann_comm = find(comm.base_symbol(), details)) {
+    if (commodity_t * ann_comm = find(comm.base->symbol, details)) {
       assert(ann_comm->annotated && as_annotated_commodity(*ann_comm).details);
       return ann_comm;
     } else {
@@ -191,6 +256,8 @@ commodity_pool_t::create(commodity_t&        comm,
   assert(! comm.has_annotation());
   assert(details);
 
+  std::lock_guard<std::recursive_mutex> guard(mutex);
+
   shared_ptr<annotated_commodity_t>
     commodity(new annotated_commodity_t(&comm, details));
 
@@ -211,7 +278,8 @@ commodity_pool_t::create(commodity_t&        comm,
 #endif
     annotated_commodities.insert(annotated_commodities_map::value_type
                                  (annotated_commodities_map::key_type
-                                  (comm.base_symbol(), details), commodity));
+                                  (comm.base->symbol, commodity->details),
+                                  commodity));
 #if DEBUG_ON
   assert(result.second);
 #endif
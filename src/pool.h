@@ -67,9 +67,39 @@ public:
    * explicitly by calling the create methods of commodity_pool_t, or
    * implicitly by parsing a commoditized amount.
    */
-  typedef std::map<string, shared_ptr<commodity_t> > commodities_map;
-  typedef std::map<std::pair<string, annotation_t>,
-                   shared_ptr<annotated_commodity_t> > annotated_commodities_map;
+  typedef std::unordered_map<string, shared_ptr<commodity_t> > commodities_map;
+
+  /**
+   * Annotated commodities are keyed by their base symbol and annotation.
+   * A key points into the annotated commodity it maps to, rather than
+   * holding copies, and carries the hash of both, which is computed once
+   * when the key is built.  Keys compare equal when neither annotation
+   * orders before the other.
+   */
+  struct annotated_key_t
+  {
+    const string *       symbol;
+    const annotation_t * details;
+    std::size_t          hash;
+
+    annotated_key_t(const string& _symbol, const annotation_t& _details);
+
+    bool operator==(const annotated_key_t& key) const {
+      return (hash == key.hash && *symbol == *key.symbol &&
+              ! (*details < *key.details) && ! (*key.details < *details));
+    }
+  };
+
+  struct annotated_key_hash_t
+  {
+    std::size_t operator()(const annotated_key_t& key) const {
+      return key.hash;
+    }
+  };
+
+  typedef std::unordered_map<annotated_key_t,
+                             shared_ptr<annotated_commodity_t>,
+                             annotated_key_hash_t> annotated_commodities_map;
 
   commodities_map           commodities;
   annotated_commodities_map annotated_commodities;
@@ -88,6 +118,18 @@ public:
 
   static shared_ptr<commodity_pool_t> current_pool;
 
+protected:
+  // Consecutive postings usually name the same commodity, so the entries
+  // matched by the last lookups are checked before hashing, without
+  // taking the lock.  Entries are never erased, and rehashing leaves them
+  // where they are.  Every other access to the maps holds the mutex; it
+  // is recursive because creating a commodity goes through the finders.
+  std::atomic<const commodities_map::value_type *>           last_found;
+  std::atomic<const annotated_commodities_map::value_type *> last_annotated;
+  std::recursive_mutex                                       mutex;
+
+public:
+
   explicit commodity_pool_t();
   virtual ~commodity_pool_t() {
     TRACE_DTOR(commodity_pool_t);
@@ -746,6 +746,7 @@ void put_post(property_tree::ptree& st, const post_t& post)
   if (post.note)
     st.put("note", *post.note);
 
+  post.parse_deferred_tags();
   if (post.metadata)
     put_metadata(st.put("metadata", ""),  *post.metadata);
 
@@ -142,14 +142,16 @@ namespace {
                  columns, unistring(leader).length());
     out << '\n';
 
+    xact.parse_deferred_tags();
     if (xact.metadata) {
-      foreach (const item_t::string_map::value_type& data, *xact.metadata) {
+      foreach (const item_t::metadata_t::value_type& data, *xact.metadata) {
         if (! data.second.second) {
           out << "    ; ";
           if (data.second.first)
-            out << data.first << ": " << *data.second.first;
+            out << item_t::tag_name(data.first) << ": "
+                << *data.second.first;
           else
-            out << ':' << data.first << ":";
+            out << ':' << item_t::tag_name(data.first) << ":";
           out << '\n';
         }
       }
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2003-2018, John Wiegley.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * - Neither the name of New Artisans LLC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <system.hh>
+
+#include "profile.h"
+
+namespace ledger {
+
+bool profile_enabled = false;
+
+namespace {
+  typedef std::map<string, profile_stage_t> directive_stages_map;
+
+  std::list<profile_stage_t> pipeline_stages;
+  directive_stages_map       directive_stages;
+
+  profile_stage_t * current_stage      = NULL;
+  time_duration     nested_time;
+  std::size_t       nested_allocations = 0;
+
+  inline ptime profile_now() {
+    return posix_time::microsec_clock::universal_time();
+  }
+
+  inline std::size_t allocation_count() {
+#if VERIFY_ON
+    if (DO_VERIFY())
+      return total_memory_allocations();
+#endif
+    return 0;
+  }
+
+  void report_stage_time(std::ostream& out, const profile_stage_t& stage)
+  {
+    out << std::setw(12) << std::fixed << std::setprecision(1)
+        << (static_cast<double>(stage.spent.total_microseconds()) / 1000.0)
+        << "ms";
+    if (DO_VERIFY())
+      out << std::setw(12) << stage.allocations;
+    else
+      out << std::setw(12) << '-';
+    out << '\n';
+  }
+}
+
+profile_scope_t::profile_scope_t(profile_stage_t& _stage, bool is_flush)
+  : stage(_stage), outer_stage(current_stage), outer_nested(nested_time),
+    outer_allocations(nested_allocations)
+{
+  if (is_flush) {
+    stage.flushes++;
+  } else {
+    stage.items_in++;
+    if (current_stage)
+      current_stage->items_out++;
+  }
+
+  current_stage      = &stage;
+  nested_time        = time_duration();
+  nested_allocations = 0;
+
+  start_allocations = allocation_count();
+  start             = profile_now();
+}
+
+profile_scope_t::~profile_scope_t()
+{
+  time_duration elapsed     = profile_now() - start;
+  std::size_t   allocations = allocation_count() - start_allocations;
+
+  stage.spent       += elapsed - nested_time;
+  stage.allocations += allocations - nested_allocations;
+
+  current_stage      = outer_stage;
+  nested_time        = outer_nested + elapsed;
+  nested_allocations = outer_allocations + allocations;
+}
+
+profile_stage_t& add_profile_stage(const string& name)
+{
+  pipeline_stages.push_front(profile_stage_t(name));
+  return pipeline_stages.front();
+}
+
+profile_stage_t& directive_profile_stage(const string& kind)
+{
+  directive_stages_map::iterator i = directive_stages.find(kind);
+  if (i == directive_stages.end())
+    i = directive_stages.insert
+      (directive_stages_map::value_type(kind, profile_stage_t(kind))).first;
+  return (*i).second;
+}
+
+void report_profile(std::ostream& out)
+{
+  std::ios_base::fmtflags flags(out.flags());
+  std::streamsize         precision(out.precision());
+
+  if (! directive_stages.empty()) {
+    out << std::left << std::setw(28) << "Directive" << std::right
+        << std::setw(10) << "Count" << std::setw(14) << "Time"
+        << std::setw(12) << "Allocs" << '\n';
+
+    foreach (const directive_stages_map::value_type& pair, directive_stages) {
+      out << "  " << std::left << std::setw(26) << pair.first << std::right
+          << std::setw(10) << pair.second.items_in;
+      report_stage_time(out, pair.second);
+    }
+  }
+
+  if (! pipeline_stages.empty()) {
+    if (! directive_stages.empty())
+      out << '\n';
+
+    out << std::left << std::setw(28) << "Report stage" << std::right
+        << std::setw(10) << "In" << std::setw(10) << "Out"
+        << std::setw(8) << "Flushes" << std::setw(14) << "Time"
+        << std::setw(12) << "Allocs" << '\n';
+
+    foreach (const profile_stage_t& stage, pipeline_stages) {
+      out << "  " << std::left << std::setw(26) << stage.name << std::right
+          << std::setw(10) << stage.items_in
+          << std::setw(10) << stage.items_out
+          << std::setw(8)  << stage.flushes;
+      report_stage_time(out, stage);
+    }
+  }
+
+  out.flags(flags);
+  out.precision(precision);
+}
+
+void clear_profile()
+{
+  pipeline_stages.clear();
+  directive_stages.clear();
+}
+
+} // namespace ledger
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2003-2018, John Wiegley.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * - Neither the name of New Artisans LLC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @addtogroup util
+ */
+
+/**
+ * @file   profile.h
+ * @author John Wiegley
+ *
+ * @ingroup util
+ *
+ * @brief Counters behind the --profile option.
+ *
+ * Each profiled stage counts the items it is handed and the time spent
+ * inside it.  Time spent in a nested stage (a later filter in the chain,
+ * or a file pulled in by an include directive) is charged to that stage
+ * only, so the times of all stages add up to the time of the whole run.
+ */
+#ifndef _PROFILE_H
+#define _PROFILE_H
+
+#include "utils.h"
+
+namespace ledger {
+
+extern bool profile_enabled;
+
+struct profile_stage_t
+{
+  string        name;
+  std::size_t   items_in;
+  std::size_t   items_out;
+  std::size_t   flushes;
+  std::size_t   allocations;
+  time_duration spent;
+
+  explicit profile_stage_t(const string& _name)
+    : name(_name), items_in(0), items_out(0), flushes(0), allocations(0) {
+    TRACE_CTOR(profile_stage_t, "const string&");
+  }
+  profile_stage_t(const profile_stage_t& other)
+    : name(other.name), items_in(other.items_in),
+      items_out(other.items_out), flushes(other.flushes),
+      allocations(other.allocations), spent(other.spent) {
+    TRACE_CTOR(profile_stage_t, "copy");
+  }
+  ~profile_stage_t() throw() {
+    TRACE_DTOR(profile_stage_t);
+  }
+};
+
+/**
+ * @brief Charge the lifetime of this object to a stage.
+ *
+ * Whatever stage is active when the scope is entered is credited with
+ * one item out, since it is the one handing an item on.
+ */
+class profile_scope_t : public noncopyable
+{
+  profile_stage_t&  stage;
+  profile_stage_t * outer_stage;
+  time_duration     outer_nested;
+  std::size_t       outer_allocations;
+  ptime             start;
+  std::size_t       start_allocations;
+
+public:
+  profile_scope_t(profile_stage_t& _stage, bool is_flush = false);
+  ~profile_scope_t();
+};
+
+profile_stage_t& add_profile_stage(const string& name);
+profile_stage_t& directive_profile_stage(const string& kind);
+
+void report_profile(std::ostream& out);
+void clear_profile();
+
+} // namespace ledger
+
+#endif // _PROFILE_H
@@ -65,6 +65,11 @@ namespace {
     return item.get_tag(tag_mask, value_mask);
   }
 
+  boost::optional<item_t::metadata_t> py_metadata(item_t& item) {
+    item.parse_deferred_tags();
+    return item.metadata;
+  }
+
   std::string py_position_pathname(position_t const& pos) {
     return pos.pathname.native();
   }
@@ -138,8 +143,7 @@ void export_item()
                   make_setter(&item_t::pos,
                               return_value_policy<return_by_value>()))
     .add_property("metadata",
-                  make_getter(&item_t::metadata,
-                              return_value_policy<return_by_value>()),
+                  make_function(py_metadata),
                   make_setter(&item_t::metadata,
                               return_value_policy<return_by_value>()))
 
@@ -49,10 +49,6 @@ namespace {
 
   post_t& posts_getitem(xact_base_t& xact, long i)
   {
-    static long last_index = 0;
-    static xact_base_t * last_xact = NULL;
-    static posts_list::iterator elem;
-
     long len = static_cast<long>(xact.posts.size());
 
     if (labs(i) >= len) {
@@ -60,20 +56,7 @@ namespace {
       throw_error_already_set();
     }
 
-    if (&xact == last_xact && i == last_index + 1) {
-      last_index = i;
-      return **++elem;
-    }
-
-    long x = i < 0 ? len + i : i;
-    elem = xact.posts.begin();
-    while (--x >= 0)
-      elem++;
-
-    last_xact = &xact;
-    last_index = i;
-
-    return **elem;
+    return *xact.posts[static_cast<std::size_t>(i < 0 ? len + i : i)];
   }
 
   string py_xact_to_string(xact_t&)
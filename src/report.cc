@@ -345,7 +345,9 @@ namespace {
 
 void report_t::posts_report(post_handler_ptr handler)
 {
-  handler = chain_post_handlers(handler, *this);
+  handler = chain_post_handlers(handler, *this,
+                                /* for_accounts_report= */ false,
+                                /* in_journal_order=    */ true);
   if (HANDLED(group_by_)) {
     unique_ptr<post_splitter>
       splitter(new post_splitter(handler, *this, HANDLER(group_by_).expr));
@@ -456,11 +458,93 @@ namespace {
   };
 }
 
+namespace {
+  template <typename Option>
+  bool has_default_value(const Option& option) {
+    return option.value == Option().value;
+  }
+
+  template <typename Option>
+  bool has_default_expr(const Option& option) {
+    return (option.expr.base_expr == Option().expr.base_expr &&
+            option.expr.exprs.empty());
+  }
+
+  // A balance report whose amounts and output depend only on the
+  // totals of each account's postings need not run every posting
+  // through the handler chain, if those totals can be found another way.
+  bool account_totals_suffice(report_t& report)
+  {
+    if (report.HANDLED(amount_) || report.HANDLED(anon) ||
+        report.HANDLED(aux_date) || report.HANDLED(by_payee) ||
+        report.HANDLED(date_) || report.HANDLED(display_) ||
+        report.HANDLED(dow) || report.HANDLED(account_) ||
+        report.HANDLED(forecast_while_) || report.HANDLED(format_) ||
+        report.HANDLED(group_by_) || report.HANDLED(inject_) ||
+        report.HANDLED(only_) || report.HANDLED(payee_) ||
+        report.HANDLED(period_) || report.HANDLED(pivot_) ||
+        report.HANDLED(prepend_format_) || report.HANDLED(related) ||
+        report.HANDLED(revalued) || report.HANDLED(sort_) ||
+        report.budget_flags != BUDGET_NO_BUDGET)
+      return false;
+
+    if (! has_default_value(report.HANDLER(balance_format_)) ||
+        ! has_default_expr(report.HANDLER(amount_)) ||
+        ! has_default_expr(report.HANDLER(display_amount_)) ||
+        ! has_default_expr(report.HANDLER(display_total_)) ||
+        ! has_default_expr(report.HANDLER(total_)))
+      return false;
+
+    return true;
+  }
+
+  // If postings are limited only by --begin and --end, the journal's
+  // running totals give each account's totals.
+  bool running_totals_suffice(report_t&         report,
+                              optional<date_t>& begin,
+                              optional<date_t>& end)
+  {
+    if (! report.HANDLED(limit_))
+      return true;
+
+    string begin_pred, end_pred;
+    if (report.HANDLED(begin_)) {
+      begin = date_interval_t(report.HANDLER(begin_).str()).begin();
+      if (! begin)
+        return false;
+      begin_pred = "date>=[" + to_iso_extended_string(*begin) + "]";
+    }
+    if (report.HANDLED(end_)) {
+      end = date_interval_t(report.HANDLER(end_).str()).begin();
+      if (! end)
+        return false;
+      end_pred = "date<[" + to_iso_extended_string(*end) + "]";
+    }
+
+    // Subtracting totals can leave zero amounts that differ in form from
+    // a direct sum, which would show up with --empty
+    if (begin && report.HANDLED(empty))
+      return false;
+
+    // The limit must be exactly what --begin and --end made of it
+    const string& limit(report.HANDLER(limit_).str());
+    if (begin && end)
+      return (limit == "(" + begin_pred + ")&(" + end_pred + ")" ||
+              limit == "(" + end_pred + ")&(" + begin_pred + ")");
+    else if (begin)
+      return limit == begin_pred;
+    else if (end)
+      return limit == end_pred;
+    return false;
+  }
+}
+
 void report_t::accounts_report(acct_handler_ptr handler)
 {
   post_handler_ptr chain =
     chain_post_handlers(post_handler_ptr(new ignore_posts), *this,
-                        /* for_accounts_report= */ true);
+                        /* for_accounts_report= */ true,
+                        /* in_journal_order=    */ true);
   if (HANDLED(group_by_)) {
     unique_ptr<post_splitter>
       splitter(new post_splitter(chain, *this, HANDLER(group_by_).expr));
@@ -475,8 +559,28 @@ void report_t::accounts_report(acct_handler_ptr handler)
   // The lifetime of the chain object controls the lifetime of all temporary
   // objects created within it during the call to pass_down_posts, which will
   // be needed later by the pass_down_accounts.
-  journal_posts_iterator walker(*session.journal.get());
-  pass_down_posts<journal_posts_iterator>(chain, walker);
+  bool totals_applied = false;
+  if (account_totals_suffice(*this)) {
+    optional<date_t> begin, end;
+    if (running_totals_suffice(*this, begin, end))
+      totals_applied = session.journal->apply_running_totals(begin, end);
+
+    // Otherwise the posting columns can answer a limit which tests only
+    // the date, account, payee and state of each posting
+    if (! totals_applied) {
+      expr_t predicate;
+      if (HANDLED(limit_))
+        predicate.parse(HANDLER(limit_).str());
+      totals_applied = session.journal->apply_post_columns(predicate);
+    }
+  }
+
+  if (totals_applied) {
+    chain->flush();
+  } else {
+    journal_posts_iterator walker(*session.journal.get());
+    pass_down_posts<journal_posts_iterator>(chain, walker);
+  }
 
   if (! HANDLED(group_by_))
     accounts_flusher(handler, *this)(value_t());
@@ -203,6 +203,7 @@ journal_t * session_t::read_journal_files()
 #endif
     read_data(master_account);
 
+  INFO_FINISH(finalize);
   INFO_FINISH(journal);
 
 #if DEBUG_ON
@@ -40,11 +40,7 @@ namespace ledger {
 
 xact_t& temporaries_t::copy_xact(xact_t& origin)
 {
-  if (! xact_temps)
-    xact_temps = std::list<xact_t>();
-
-  xact_temps->push_back(origin);
-  xact_t& temp(xact_temps->back());
+  xact_t& temp(xact_temps.emplace_back(origin));
 
   temp.add_flags(ITEM_TEMP);
   return temp;
@@ -52,11 +48,7 @@ xact_t& temporaries_t::copy_xact(xact_t& origin)
 
 xact_t& temporaries_t::create_xact()
 {
-  if (! xact_temps)
-    xact_temps = std::list<xact_t>();
-
-  xact_temps->push_back(xact_t());
-  xact_t& temp(xact_temps->back());
+  xact_t& temp(xact_temps.emplace_back());
 
   temp.add_flags(ITEM_TEMP);
   return temp;
@@ -65,11 +57,7 @@ xact_t& temporaries_t::create_xact()
 post_t& temporaries_t::copy_post(post_t& origin, xact_t& xact,
                                  account_t * account)
 {
-  if (! post_temps)
-    post_temps = std::list<post_t>();
-
-  post_temps->push_back(origin);
-  post_t& temp(post_temps->back());
+  post_t& temp(post_temps.emplace_back(origin));
 
   temp.add_flags(ITEM_TEMP);
   if (account)
@@ -84,11 +72,7 @@ post_t& temporaries_t::copy_post(post_t& origin, xact_t& xact,
 post_t& temporaries_t::create_post(xact_t& xact, account_t * account,
                                    bool bidir_link)
 {
-  if (! post_temps)
-    post_temps = std::list<post_t>();
-
-  post_temps->push_back(post_t(account));
-  post_t& temp(post_temps->back());
+  post_t& temp(post_temps.emplace_back(account));
 
   temp.add_flags(ITEM_TEMP);
   temp.account = account;
@@ -105,11 +89,7 @@ post_t& temporaries_t::create_post(xact_t& xact, account_t * account,
 account_t& temporaries_t::create_account(const string& name,
                                          account_t *   parent)
 {
-  if (! acct_temps)
-    acct_temps = std::list<account_t>();
-
-  acct_temps->push_back(account_t(parent, name));
-  account_t& temp(acct_temps->back());
+  account_t& temp(acct_temps.emplace_back(parent, name));
 
   temp.add_flags(ACCOUNT_TEMP);
   if (parent)
@@ -120,27 +100,42 @@ account_t& temporaries_t::create_account(const string& name,
 
 void temporaries_t::clear()
 {
-  if (post_temps) {
-    foreach (post_t& post, *post_temps) {
-      if (! post.xact->has_flags(ITEM_TEMP))
-        post.xact->remove_post(&post);
-
-      if (post.account && ! post.account->has_flags(ACCOUNT_TEMP))
-        post.account->remove_post(&post);
+  // Unlink the temporary postings from the real accounts they were added
+  // to with a single pass over each such account's postings, since
+  // removing them one at a time is quadratic in the number of postings
+  // generated by forecasts and budgets.
+  std::unordered_set<post_t *>    temp_posts;
+  std::unordered_set<account_t *> accounts;
+
+  for (std::size_t i = 0; i < post_temps.size(); i++) {
+    post_t& post(post_temps[i]);
+
+    if (! post.xact->has_flags(ITEM_TEMP))
+      post.xact->remove_post(&post);
+
+    if (post.account && ! post.account->has_flags(ACCOUNT_TEMP)) {
+      temp_posts.insert(&post);
+      accounts.insert(post.account);
+      post.account = NULL;
     }
-    post_temps->clear();
   }
+  foreach (account_t * acct, accounts)
+    acct->posts.erase(std::remove_if(acct->posts.begin(), acct->posts.end(),
+                                     [&](post_t * post) {
+                                       return temp_posts.count(post) > 0;
+                                     }),
+                      acct->posts.end());
+  post_temps.clear();
 
-  if (xact_temps)
-    xact_temps->clear();
+  xact_temps.clear();
 
-  if (acct_temps) {
-    foreach (account_t& acct, *acct_temps) {
-      if (acct.parent && ! acct.parent->has_flags(ACCOUNT_TEMP))
-        acct.parent->remove_account(&acct);
-    }
-    acct_temps->clear();
+  for (std::size_t i = 0; i < acct_temps.size(); i++) {
+    account_t& acct(acct_temps[i]);
+
+    if (acct.parent && ! acct.parent->has_flags(ACCOUNT_TEMP))
+      acct.parent->remove_account(&acct);
   }
+  acct_temps.clear();
 }
 
 } // namespace ledger
@@ -44,11 +44,108 @@
 
 namespace ledger {
 
+/**
+ * @brief A chunked, append-only store for temporary objects.
+ *
+ * Objects are constructed in place within fixed-size blocks, so that
+ * their addresses stay stable and no per-object node is allocated.
+ * Clearing the slab destroys its objects but keeps the blocks for
+ * reuse, and the blocks of a destroyed slab are kept in a small per-type
+ * cache for the next slab, since report filters are rebuilt for every
+ * command run by the REPL or server.
+ */
+template <typename T>
+class temporaries_slab_t : public noncopyable
+{
+  static const std::size_t block_size      = 32;
+  static const std::size_t max_free_blocks = 64;
+
+  struct free_block_t {
+    free_block_t * next;
+  };
+
+  static free_block_t * free_blocks;
+  static std::size_t    free_blocks_count;
+
+  std::vector<T *> blocks;
+  std::size_t      count;
+
+  static T * allocate_block() {
+    if (free_blocks) {
+      free_block_t * block = free_blocks;
+      free_blocks = block->next;
+      --free_blocks_count;
+      return reinterpret_cast<T *>(block);
+    }
+    return static_cast<T *>(::operator new(sizeof(T) * block_size));
+  }
+  static void release_block(T * block) {
+    if (free_blocks_count < max_free_blocks) {
+      free_block_t * node = reinterpret_cast<free_block_t *>(block);
+      node->next = free_blocks;
+      free_blocks = node;
+      ++free_blocks_count;
+    } else {
+      ::operator delete(block);
+    }
+  }
+
+public:
+  temporaries_slab_t() : count(0) {
+    TRACE_CTOR(temporaries_slab_t, "");
+  }
+  ~temporaries_slab_t() {
+    TRACE_DTOR(temporaries_slab_t);
+    clear();
+    foreach (T * block, blocks)
+      release_block(block);
+  }
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    if (count == blocks.size() * block_size)
+      blocks.push_back(allocate_block());
+
+    T * ptr = blocks[count / block_size] + count % block_size;
+    new (ptr) T(std::forward<Args>(args)...);
+    ++count;
+    return *ptr;
+  }
+
+  std::size_t size() const {
+    return count;
+  }
+  bool empty() const {
+    return count == 0;
+  }
+
+  T& operator[](std::size_t index) {
+    assert(index < count);
+    return blocks[index / block_size][index % block_size];
+  }
+  T& back() {
+    return (*this)[count - 1];
+  }
+
+  void clear() {
+    for (std::size_t i = 0; i < count; i++)
+      (*this)[i].~T();
+    count = 0;
+  }
+};
+
+template <typename T>
+typename temporaries_slab_t<T>::free_block_t *
+temporaries_slab_t<T>::free_blocks = NULL;
+
+template <typename T>
+std::size_t temporaries_slab_t<T>::free_blocks_count = 0;
+
 class temporaries_t
 {
-  optional<std::list<xact_t> >    xact_temps;
-  optional<std::list<post_t> >    post_temps;
-  optional<std::list<account_t> > acct_temps;
+  temporaries_slab_t<xact_t>    xact_temps;
+  temporaries_slab_t<post_t>    post_temps;
+  temporaries_slab_t<account_t> acct_temps;
 
 public:
   temporaries_t() {
@@ -62,19 +159,19 @@ public:
   xact_t&    copy_xact(xact_t& origin);
   xact_t&    create_xact();
   xact_t&    last_xact() {
-    return xact_temps->back();
+    return xact_temps.back();
   }
   post_t&    copy_post(post_t& origin, xact_t& xact,
                        account_t * account = NULL);
   post_t&    create_post(xact_t& xact, account_t * account,
                          bool bidir_link = true);
   post_t&    last_post() {
-    return post_temps->back();
+    return post_temps.back();
   }
   account_t& create_account(const string& name   = "",
                             account_t *   parent = NULL);
   account_t& last_account() {
-    return acct_temps->back();
+    return acct_temps.back();
   }
 
   void clear();
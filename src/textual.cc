@@ -40,6 +40,7 @@
 #include "query.h"
 #include "pstream.h"
 #include "pool.h"
+#include "profile.h"
 #if HAVE_BOOST_PYTHON
 #include "pyinterp.h"
 #endif
@@ -337,6 +338,47 @@ std::streamsize instance_t::read_line(char *& line)
   return 0;
 }
 
+namespace {
+  // The name a line is counted under by --profile
+  string directive_kind(const char * line)
+  {
+    switch (*line) {
+    case ' ':
+    case '\t':
+      return "(indented line)";
+    case ';':
+    case '#':
+    case '*':
+    case '|':
+      return "(comment)";
+    case '-':
+      return "(option)";
+    case '=':
+      return "(automated xact)";
+    case '~':
+      return "(period xact)";
+    case '@':
+    case '!':
+      line++;
+      break;
+    default:
+      if (std::isdigit(*line))
+        return "(xact)";
+      break;
+    }
+
+    // Single letter directives, such as P or Y, may run into their
+    // argument.
+    if (std::isupper(*line))
+      return string(line, 1);
+
+    const char * end = line;
+    while (*end && ! std::isspace(*end))
+      end++;
+    return string(line, end);
+  }
+}
+
 void instance_t::read_next_directive(bool& error_flag)
 {
   char * line;
@@ -344,6 +386,11 @@ void instance_t::read_next_directive(bool& error_flag)
   if (len == 0 || line == NULL)
     return;
 
+  unique_ptr<profile_scope_t> profile_scope;
+  if (profile_enabled)
+    profile_scope.reset
+      (new profile_scope_t(directive_profile_stage(directive_kind(line))));
+
   if (! std::isspace(line[0]))
     error_flag = false;
 
@@ -1483,14 +1530,21 @@ post_t * instance_t::parse_post(char *          line,
 
   if (next && *next && (*next != ';' && *next != '=')) {
     beg = static_cast<std::streamsize>(next - line);
-    ptristream stream(next, static_cast<std::size_t>(len - beg));
 
-    if (*next != '(')           // indicates a value expression
-      post->amount.parse(stream, PARSE_NO_REDUCE);
-    else
+    // Where the amount ends, or NULL if it runs to the end of the line
+    const char * amount_end;
+
+    if (*next != '(') {         // indicates a value expression
+      amount_end = next;
+      post->amount.parse(amount_end, PARSE_NO_REDUCE);
+    } else {
+      ptristream stream(next, static_cast<std::size_t>(len - beg));
       parse_amount_expr(stream, *context.scope, *post.get(), post->amount,
                         PARSE_NO_REDUCE | PARSE_SINGLE | PARSE_NO_ASSIGN,
                         defer_expr, &post->amount_expr);
+      amount_end = (stream.eof() ? NULL :
+                    next + static_cast<std::ptrdiff_t>(stream.tellg()));
+    }
 
     DEBUG("textual.parse", "line " << context.linenum << ": "
           << "post amount = " << post->amount);
@@ -1514,10 +1568,10 @@ post_t * instance_t::parse_post(char *          line,
       }
     }
 
-    if (stream.eof()) {
+    if (! amount_end) {
       next = NULL;
     } else {
-      next = skip_ws(next + static_cast<std::ptrdiff_t>(stream.tellg()));
+      next = skip_ws(next + (amount_end - next));
 
       // Parse the optional cost (@ PER-UNIT-COST, @@ TOTAL-COST)
 
@@ -1555,13 +1609,18 @@ post_t * instance_t::parse_post(char *          line,
           }
 
           beg = static_cast<std::streamsize>(p - line);
-          ptristream cstream(p, static_cast<std::size_t>(len - beg));
+          const char * cost_end;
 
-          if (*p != '(')                // indicates a value expression
-            post->cost->parse(cstream, PARSE_NO_MIGRATE);
-          else
+          if (*p != '(') {              // indicates a value expression
+            cost_end = p;
+            post->cost->parse(cost_end, PARSE_NO_MIGRATE);
+          } else {
+            ptristream cstream(p, static_cast<std::size_t>(len - beg));
             parse_amount_expr(cstream, *context.scope, *post.get(), *post->cost,
                               PARSE_NO_MIGRATE | PARSE_SINGLE | PARSE_NO_ASSIGN);
+            cost_end = (cstream.eof() ? NULL :
+                        p + static_cast<std::ptrdiff_t>(cstream.tellg()));
+          }
 
           if (post->cost->sign() < 0)
             throw parse_error(_("A posting's cost may not be negative"));
@@ -1590,10 +1649,10 @@ post_t * instance_t::parse_post(char *          line,
           DEBUG("textual.parse", "line " << context.linenum << ": "
                 << "Annotated amount is " << post->amount);
 
-          if (cstream.eof())
+          if (! cost_end)
             next = NULL;
           else
-            next = skip_ws(p + static_cast<std::ptrdiff_t>(cstream.tellg()));
+            next = skip_ws(p + (cost_end - p));
         } else {
           throw parse_error(_("Expected a cost amount"));
         }
@@ -1614,14 +1673,19 @@ post_t * instance_t::parse_post(char *          line,
       post->assigned_amount = amount_t();
 
       beg = static_cast<std::streamsize>(p - line);
-      ptristream stream(p, static_cast<std::size_t>(len - beg));
+      const char * assigned_end;
 
-      if (*p != '(')            // indicates a value expression
-        post->assigned_amount->parse(stream, PARSE_NO_MIGRATE);
-      else
+      if (*p != '(') {          // indicates a value expression
+        assigned_end = p;
+        post->assigned_amount->parse(assigned_end, PARSE_NO_MIGRATE);
+      } else {
+        ptristream stream(p, static_cast<std::size_t>(len - beg));
         parse_amount_expr(stream, *context.scope, *post.get(),
                           *post->assigned_amount,
                           PARSE_SINGLE | PARSE_NO_MIGRATE);
+        assigned_end = (stream.eof() ? NULL :
+                        p + static_cast<std::ptrdiff_t>(stream.tellg()));
+      }
 
       if (post->assigned_amount->is_null()) {
         if (post->amount.is_null())
@@ -1711,10 +1775,10 @@ post_t * instance_t::parse_post(char *          line,
         }
       }
 
-      if (stream.eof())
+      if (! assigned_end)
         next = NULL;
       else
-        next = skip_ws(p + static_cast<std::ptrdiff_t>(stream.tellg()));
+        next = skip_ws(p + (assigned_end - p));
     } else {
       throw parse_error(_("Expected an balance assignment/assertion amount"));
     }
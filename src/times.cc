@@ -1297,6 +1297,49 @@ void date_interval_t::stabilize(const optional<date_t>& date)
   }
 }
 
+namespace {
+  // Return the start of the last period, stepping from scan by duration,
+  // which begins on or before date.  Months and years stepped from near
+  // the end of a month are clipped to shorter months along the way, so
+  // those are left for the caller to walk one period at a time.
+  date_t skip_whole_periods(const date_duration_t& duration,
+                            const date_t& scan, const date_t& date)
+  {
+    if (duration.length <= 0 || date <= scan)
+      return scan;
+
+    switch (duration.quantum) {
+    case date_duration_t::DAYS:
+    case date_duration_t::WEEKS: {
+      long span = duration.length;
+      if (duration.quantum == date_duration_t::WEEKS)
+        span *= 7;
+      return scan + gregorian::days(((date - scan).days() / span) * span);
+    }
+
+    case date_duration_t::MONTHS:
+    case date_duration_t::QUARTERS:
+    case date_duration_t::YEARS: {
+      if (scan.day() >= 28)
+        return scan;
+
+      long span = duration.length;
+      if (duration.quantum == date_duration_t::QUARTERS)
+        span *= 3;
+      else if (duration.quantum == date_duration_t::YEARS)
+        span *= 12;
+
+      long months = ((static_cast<long>(date.year()) - scan.year()) * 12 +
+                     (static_cast<long>(date.month()) - scan.month()));
+      if (date.day() < scan.day())
+        --months;
+      return scan + gregorian::months((months / span) * span);
+    }
+    }
+    return scan;
+  }
+}
+
 bool date_interval_t::find_period(const date_t& date,
                                   const bool    allow_shift)
 {
@@ -1347,6 +1390,14 @@ bool date_interval_t::find_period(const date_t& date,
     DEBUG("times.interval", "finish is not set");
 #endif
 
+  if (allow_shift && duration) {
+    scan = skip_whole_periods(*duration, scan, date);
+    if (scan != *start) {
+      end_of_scan = duration->add(scan);
+      DEBUG("times.interval", "skipped to scan = " << scan);
+    }
+  }
+
   while (date >= scan && (! finish || scan < *finish)) {
     if (date < end_of_scan) {
       start           = scan;
@@ -153,6 +153,15 @@ std::size_t current_memory_size()
   return memory_size;
 }
 
+std::size_t total_memory_allocations()
+{
+  if (! total_memory_count)
+    return 0;
+
+  object_count_map::const_iterator i = total_memory_count->find("__ALL__");
+  return i != total_memory_count->end() ? (*i).second.first : 0;
+}
+
 //#if !defined(__has_feature) || !__has_feature(address_sanitizer)
 
 static void trace_new_func(void * ptr, const char * which, std::size_t size)
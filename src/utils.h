@@ -146,6 +146,7 @@ void shutdown_memory_tracing();
 
 std::size_t current_memory_size();
 std::size_t current_objects_size();
+std::size_t total_memory_allocations();
 
 void trace_ctor_func(void * ptr, const char * cls_name, const char * args,
                      std::size_t cls_size);
@@ -43,6 +43,58 @@ namespace ledger {
 intrusive_ptr<value_t::storage_t> value_t::true_value;
 intrusive_ptr<value_t::storage_t> value_t::false_value;
 
+std::size_t value_t::storage_t::heap_allocations = 0;
+
+namespace {
+  struct free_storage_t {
+    free_storage_t * next;
+  };
+
+  // Released storage objects waiting to be reused.  Only a bounded number
+  // are kept, so that a burst of values (such as a long sequence) does not
+  // pin its memory for the rest of the run.
+  free_storage_t * free_storage       = NULL;
+  std::size_t      free_storage_count = 0;
+
+  const std::size_t max_free_storage = 1024;
+
+  void release_free_storage()
+  {
+    while (free_storage) {
+      free_storage_t * next = free_storage->next;
+      ::operator delete(free_storage);
+      free_storage = next;
+    }
+    free_storage_count = 0;
+  }
+}
+
+void * value_t::storage_t::operator new(std::size_t size)
+{
+  assert(size == sizeof(storage_t));
+  if (free_storage) {
+    free_storage_t * result = free_storage;
+    free_storage = result->next;
+    --free_storage_count;
+    return result;
+  }
+  ++heap_allocations;
+  return ::operator new(size);
+}
+
+void value_t::storage_t::operator delete(void * ptr, std::size_t size)
+{
+  assert(size == sizeof(storage_t));
+  if (free_storage_count < max_free_storage) {
+    free_storage_t * node = static_cast<free_storage_t *>(ptr);
+    node->next = free_storage;
+    free_storage = node;
+    ++free_storage_count;
+  } else {
+    ::operator delete(ptr);
+  }
+}
+
 value_t::storage_t& value_t::storage_t::operator=(const value_t::storage_t& rhs)
 {
   type = rhs.type;
@@ -78,6 +130,8 @@ void value_t::shutdown()
 {
   true_value  = intrusive_ptr<storage_t>();
   false_value = intrusive_ptr<storage_t>();
+
+  release_free_storage();
 }
 
 value_t::operator bool() const
@@ -1795,8 +1849,14 @@ value_t value_t::strip_annotations(const keep_details_t& what_to_keep) const
   }
 
   case AMOUNT:
+    if (what_to_keep.keep_all(as_amount().commodity()))
+      return *this;
     return as_amount().strip_annotations(what_to_keep);
   case BALANCE:
+    // Returning this value, rather than a copy of its balance, shares
+    // the storage of a balance that has nothing to strip.
+    if (! as_balance().needs_stripping(what_to_keep))
+      return *this;
     return as_balance().strip_annotations(what_to_keep);
   }
 
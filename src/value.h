@@ -159,6 +159,17 @@ public:
     }
 
   public:                       // so `checked_delete' can access it
+    /**
+     * Allocation.  Most values created while evaluating expressions are
+     * short-lived scalars, so storage objects are recycled through a free
+     * list instead of going back to the heap each time.  `heap_allocations'
+     * counts the storage objects that actually had to be allocated.
+     */
+    static void * operator new(std::size_t size);
+    static void   operator delete(void * ptr, std::size_t size);
+
+    static std::size_t heap_allocations;
+
     /**
      * Destructor.  Must only be called when the reference count has
      * reached zero.  The `destroy' method is used to do the actual
@@ -560,7 +571,6 @@ public:
     return boost::get<bool>(storage->data);
   }
   void set_boolean(const bool val) {
-    set_type(BOOLEAN);
     storage = val ? true_value : false_value;
   }
 
@@ -78,7 +78,7 @@ void xact_base_t::add_post(post_t * post)
 
 bool xact_base_t::remove_post(post_t * post)
 {
-  posts.remove(post);
+  posts.erase(std::remove(posts.begin(), posts.end(), post), posts.end());
   post->xact = NULL;
   return true;
 }
@@ -161,8 +161,12 @@ bool xact_base_t::finalize()
 
   value_t  balance;
   post_t * null_post = NULL;
+  bool     has_costs = false;
 
   foreach (post_t * post, posts) {
+    if (post->cost)
+      has_costs = true;
+
     if (! post->must_balance())
       continue;
 
@@ -272,6 +276,7 @@ bool xact_base_t::finalize()
             post->cost = per_unit_cost * amt;
             post->add_flags(POST_COST_CALCULATED);
             balance += *post->cost;
+            has_costs = true;
 
             DEBUG("xact.finalize", "set post->cost to = " << *post->cost);
           }
@@ -280,10 +285,10 @@ bool xact_base_t::finalize()
     }
   }
 
-  posts_list copy(posts);
-
-  if (has_date()) {
-    foreach (post_t * post, copy) {
+  // Most transactions have no costs at all, in which case there is nothing
+  // to exchange and no need to walk the postings again.
+  if (has_costs && has_date()) {
+    foreach (post_t * post, posts) {
       if (! post->cost)
         continue;
 
@@ -854,6 +859,7 @@ void put_xact(property_tree::ptree& st, const xact_t& xact)
   if (xact.note)
     st.put("note", *xact.note);
 
+  xact.parse_deferred_tags();
   if (xact.metadata)
     put_metadata(st.put("metadata", ""),  *xact.metadata);
 }
@@ -51,7 +51,7 @@ class post_t;
 class journal_t;
 class parse_context_t;
 
-typedef std::list<post_t *> posts_list;
+typedef std::vector<post_t *> posts_list;
 
 class xact_base_t : public item_t
 {
@@ -191,6 +191,10 @@ public:
     deferred_notes->push_back(deferred_tag_data_t(p, overwrite_existing));
     deferred_notes->back().apply_to_post = active_post;
   }
+  virtual void parse_note_tags(std::size_t offset, scope_t& scope,
+                               bool overwrite_existing = true) {
+    parse_tags(note->c_str() + offset, scope, overwrite_existing);
+  }
 
   virtual void extend_xact(xact_base_t& xact, parse_context_t& context);
 };
@@ -228,7 +232,7 @@ class period_xact_t : public xact_base_t
   }
 };
 
-typedef std::list<xact_t *>        xacts_list;
+typedef std::vector<xact_t *>      xacts_list;
 typedef std::list<auto_xact_t *>   auto_xacts_list;
 typedef std::list<period_xact_t *> period_xacts_list;
 
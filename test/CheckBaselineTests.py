@@ -31,6 +31,7 @@ class CheckBaselineTests (CheckOptions):
         'no-pager',
         'options',
         'price-exp',
+        'profile',
         'revalued-total',
         'seed',
         'trace',
@@ -134,6 +134,40 @@ BOOST_AUTO_TEST_CASE(testParser)
   BOOST_CHECK(x12.valid());
 }
 
+#ifndef NOT_FOR_PYTHON
+BOOST_AUTO_TEST_CASE(testPointerParser)
+{
+  const char * inputs[] = {
+    "$100.00  ; note", "-10 EUR", "EUR -1,000.50 @ $2", "10 \"ABC 1\"",
+    "1.000.000,25 DKK", "3 AAPL {$10.00} [2020/01/01]", "12345678901234567890 X",
+    "\xe2\x82\xac 5", "7 and", "1.5."
+  };
+
+  foreach (const char * input, inputs) {
+    amount_t x1;
+    std::istringstream stream(input);
+    x1.parse(stream, PARSE_NO_MIGRATE);
+
+    amount_t x2;
+    const char * p = input;
+    x2.parse(p, PARSE_NO_MIGRATE);
+
+    BOOST_CHECK_EQUAL(x1, x2);
+    BOOST_CHECK_EQUAL(x1.to_fullstring(), x2.to_fullstring());
+    if (stream.eof())
+      BOOST_CHECK_EQUAL('\0', *p);
+    else
+      BOOST_CHECK_EQUAL(static_cast<std::ptrdiff_t>(stream.tellg()),
+                        p - input);
+    BOOST_CHECK(x2.valid());
+  }
+
+  amount_t x3;
+  const char * p = "DM";
+  BOOST_CHECK_THROW(x3.parse(p), amount_error);
+}
+#endif // NOT_FOR_PYTHON
+
 BOOST_AUTO_TEST_CASE(testConstructors)
 {
   amount_t x0;
@@ -219,6 +253,29 @@ BOOST_AUTO_TEST_CASE(testCommodityConstructors)
   BOOST_CHECK(x10.valid());
 }
 
+BOOST_AUTO_TEST_CASE(testDecimalPrinting)
+{
+  amount_t x1("1,000.000 XDP");
+
+  BOOST_CHECK_EQUAL(string("1,000.000 XDP"), x1.to_string());
+  BOOST_CHECK_EQUAL(string("1,234,567.891 XDP"),
+                    (x1 * amount_t("1234.56789149")).to_string());
+  BOOST_CHECK_EQUAL(string("-1,234,567.892 XDP"),
+                    (x1 * amount_t("-1234.56789151")).to_string());
+  BOOST_CHECK_EQUAL(string("0.001 XDP"),
+                    (x1 * amount_t("0.00000051")).to_string());
+  BOOST_CHECK_EQUAL(string("-0.000 XDP"),
+                    (x1 * amount_t("-0.0000004")).to_string());
+  BOOST_CHECK_EQUAL(string("0.125 XDP"),
+                    (x1 / amount_t(8000L)).to_string());
+  BOOST_CHECK_EQUAL(string("0.333 XDP"),
+                    (x1 / amount_t(3000L)).to_string());
+  BOOST_CHECK_EQUAL(string("-0.667 XDP"),
+                    (x1 / amount_t(-1500L)).to_string());
+
+  BOOST_CHECK(x1.valid());
+}
+
 #ifndef NOT_FOR_PYTHON
 
 BOOST_AUTO_TEST_CASE(testAssignment)
@@ -1331,6 +1388,33 @@ BOOST_AUTO_TEST_CASE(testCommodityConversion)
   BOOST_CHECK(x1.valid());
 }
 
+BOOST_AUTO_TEST_CASE(testScaledConversion)
+{
+  amount_t x0;
+  amount_t x1("$-1234.56");
+  amount_t x2("12345682348723487324");
+  amount_t x3(amount_t(1L) / amount_t(3L));
+  long     scaled = 0;
+
+  BOOST_CHECK_THROW(x0.to_scaled_long(2, scaled), amount_error);
+  BOOST_CHECK(x1.to_scaled_long(2, scaled));
+  BOOST_CHECK_EQUAL(-123456L, scaled);
+  BOOST_CHECK(x1.to_scaled_long(4, scaled));
+  BOOST_CHECK_EQUAL(-12345600L, scaled);
+  BOOST_CHECK(! x1.to_scaled_long(1, scaled));
+  BOOST_CHECK(! x2.to_scaled_long(0, scaled));
+  BOOST_CHECK(! x3.to_scaled_long(18, scaled));
+
+  amount_t x4(amount_t::scaled(-123456L, 2));
+  BOOST_CHECK_EQUAL(amount_t("-1234.56"), x4);
+  BOOST_CHECK_EQUAL(2, x4.precision());
+  BOOST_CHECK_EQUAL(string("-1234.56"), x4.to_string());
+  BOOST_CHECK_EQUAL(amount_t(7L), amount_t::scaled(7L, 0));
+
+  BOOST_CHECK(x1.valid());
+  BOOST_CHECK(x4.valid());
+}
+
 #ifndef NOT_FOR_PYTHON
 
 BOOST_AUTO_TEST_CASE(testPrinting)
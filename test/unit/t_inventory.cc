@@ -0,0 +1,113 @@
+#define BOOST_TEST_DYN_LINK
+//#define BOOST_TEST_MODULE inventory
+#include <boost/test/unit_test.hpp>
+
+#include <system.hh>
+
+#include "inventory.h"
+#include "commodity.h"
+
+using namespace ledger;
+
+struct inventory_fixture {
+  inventory_fixture() {
+  times_initialize();
+  amount_t::initialize();
+
+  // Cause the display precision for dollars to be initialized to 2.
+  amount_t x1("$1.00");
+  BOOST_CHECK(x1);
+
+  amount_t::stream_fullstrings = true; // make reports from UnitTests accurate
+  }
+
+  ~inventory_fixture()
+  {
+  amount_t::stream_fullstrings = false;
+  amount_t::shutdown();
+  times_shutdown();
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(inventory, inventory_fixture)
+
+BOOST_AUTO_TEST_CASE(testAddition)
+{
+  inventory_t inv;
+
+  inv += amount_t("10 AAPL {$20.00} [2012/03/01]");
+  inv += amount_t("10 AAPL {$10.00} [2012/01/01]");
+  inv += amount_t("5 AAPL");
+  inv += amount_t("$100.00");
+
+  BOOST_CHECK_EQUAL(amount_t("25 AAPL"), inv.quantity(amount_t("1 AAPL").commodity()));
+  BOOST_CHECK_EQUAL(balance_t("$300.00"), inv.cost_basis(amount_t("1 AAPL").commodity()));
+  BOOST_CHECK_EQUAL(amount_t("$100.00"), inv.quantity(amount_t("$1.00").commodity()));
+  BOOST_CHECK_EQUAL(amount_t(0L), inv.quantity(amount_t("1 MSFT").commodity()));
+
+  const inventory_t::holding_t * holding =
+    inv.find_holding(amount_t("1 AAPL").commodity());
+  BOOST_CHECK(holding);
+  BOOST_CHECK_EQUAL(2UL, holding->lots.size());
+  BOOST_CHECK_EQUAL(amount_t("10 AAPL {$10.00} [2012/01/01]"),
+                    holding->lots.begin()->second);
+
+  inv -= amount_t("10 AAPL {$20.00} [2012/03/01]");
+  BOOST_CHECK_EQUAL(1UL, holding->lots.size());
+  BOOST_CHECK_EQUAL(amount_t("15 AAPL"), inv.quantity(amount_t("1 AAPL").commodity()));
+  BOOST_CHECK_EQUAL(balance_t("$100.00"), inv.cost_basis(amount_t("1 AAPL").commodity()));
+
+  balance_t bal(inv.to_balance());
+  BOOST_CHECK_EQUAL(3UL, bal.amounts.size());
+  BOOST_CHECK_EQUAL(inv.to_balance(), inventory_t(bal).to_balance());
+
+  BOOST_CHECK(inv.valid());
+}
+
+BOOST_AUTO_TEST_CASE(testRelief)
+{
+  inventory_t inv;
+
+  inv += amount_t("10 AAPL {$10.00} [2012/01/01]");
+  inv += amount_t("10 AAPL {$20.00} [2012/02/01]");
+  inv += amount_t("10 AAPL {$30.00} [2012/03/01]");
+
+  inventory_t lifo(inv);
+
+  BOOST_CHECK_EQUAL(balance_t("$200.00"), inv.relieve(amount_t("15 AAPL")));
+  BOOST_CHECK_EQUAL(amount_t("15 AAPL"), inv.quantity(amount_t("1 AAPL").commodity()));
+  BOOST_CHECK_EQUAL(balance_t("$400.00"), inv.cost_basis(amount_t("1 AAPL").commodity()));
+
+  BOOST_CHECK_EQUAL(balance_t("$400.00"),
+                    lifo.relieve(amount_t("15 AAPL"), inventory_t::RELIEVE_LIFO));
+  BOOST_CHECK_EQUAL(balance_t("$200.00"), lifo.cost_basis(amount_t("1 AAPL").commodity()));
+
+  BOOST_CHECK_THROW(inv.relieve(amount_t("16 AAPL")), inventory_error);
+  BOOST_CHECK_EQUAL(amount_t("15 AAPL"), inv.quantity(amount_t("1 AAPL").commodity()));
+  BOOST_CHECK_THROW(inv.relieve(amount_t("1 MSFT")), inventory_error);
+
+  BOOST_CHECK_EQUAL(balance_t("$400.00"), inv.relieve(amount_t("15 AAPL")));
+  BOOST_CHECK(inv.is_empty());
+
+  BOOST_CHECK(inv.valid());
+  BOOST_CHECK(lifo.valid());
+}
+
+BOOST_AUTO_TEST_CASE(testAverageLotPrices)
+{
+  inventory_t inv;
+
+  inv += amount_t("10 AAPL {$10.00} [2012/02/01]");
+  inv += amount_t("30 AAPL {$20.00} [2012/01/01]");
+  inv += amount_t("$5.00");
+
+  balance_t avg(inv.average_lot_prices());
+  BOOST_CHECK_EQUAL(2UL, avg.amounts.size());
+  BOOST_CHECK_EQUAL(balance_t(amount_t("40 AAPL {$17.50} [2012/01/01]")) +
+                    amount_t("$5.00"), avg);
+  BOOST_CHECK_EQUAL(avg, average_lot_prices(inv.to_balance()));
+
+  BOOST_CHECK(inv.valid());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,209 @@
+#define BOOST_TEST_DYN_LINK
+//#define BOOST_TEST_MODULE threads
+#include <boost/test/unit_test.hpp>
+
+#include <system.hh>
+
+#include <thread>
+
+#include "amount.h"
+#include "commodity.h"
+#include "annotate.h"
+#include "pool.h"
+
+using namespace ledger;
+
+struct threads_fixture {
+  threads_fixture() {
+  times_initialize();
+  amount_t::initialize();
+
+  // Cause the display precision for dollars to be initialized to 2.
+  amount_t x1("$1.00");
+  BOOST_CHECK(x1);
+
+  amount_t::stream_fullstrings = true; // make reports from UnitTests accurate
+  }
+
+  ~threads_fixture() {
+  amount_t::stream_fullstrings = false;
+  amount_t::shutdown();
+  times_shutdown();
+  }
+};
+
+namespace {
+  const std::size_t thread_count = 4;
+  const long        iterations   = 500;
+
+  // Run fn on several threads at once, and return how many of its checks
+  // failed.  The Boost.Test checks themselves are not thread-safe, so
+  // each thread only counts its failures.
+  std::size_t run_concurrently(function<std::size_t (std::size_t)> fn)
+  {
+    std::vector<std::size_t> failures(thread_count, 0);
+    std::vector<std::thread> threads;
+
+    for (std::size_t t = 0; t < thread_count; t++)
+      threads.push_back(std::thread([&fn, &failures, t]() {
+            try {
+              failures[t] = fn(t);
+            }
+            catch (...) {
+              failures[t] = 1;
+            }
+          }));
+
+    std::size_t total = 0;
+    for (std::size_t t = 0; t < thread_count; t++) {
+      threads[t].join();
+      total += failures[t];
+    }
+    return total;
+  }
+
+  // Exercises parsing, arithmetic, rounding, conversion and printing,
+  // both of amounts with decimal fractions and of true fractions.
+  string amount_scenario(long i)
+  {
+    amount_t x1("$123.45");
+    amount_t x2("-123.45 euro");
+    amount_t x3(i);
+
+    std::ostringstream out;
+    out << (x1 * x3).to_string() << ' '
+        << (x1 / amount_t(i + 1)).to_string() << ' '
+        << (x2 / amount_t(7L) * x3).to_fullstring() << ' '
+        << (x1 - x3).rounded().to_string() << ' '
+        << (x2 * amount_t("0.125")).truncated().to_string() << ' '
+        << (x1 / amount_t(3L)).floored().to_string() << ' '
+        << (x2 / amount_t(i + 3)).is_zero() << ' '
+        << (x1 * x3).to_double();
+    return out.str();
+  }
+}
+
+BOOST_FIXTURE_TEST_SUITE(threads, threads_fixture)
+
+BOOST_AUTO_TEST_CASE(testConcurrentArithmetic)
+{
+  std::vector<string> expected;
+  for (long i = 0; i < iterations; i++)
+    expected.push_back(amount_scenario(i));
+
+  BOOST_CHECK_EQUAL(0U, run_concurrently([&expected](std::size_t t) {
+        std::size_t failures = 0;
+        for (long n = 0; n < iterations; n++) {
+          long i = (n + static_cast<long>(t) * 97) % iterations;
+          if (amount_scenario(i) != expected[static_cast<std::size_t>(i)])
+            failures++;
+        }
+        return failures;
+      }));
+}
+
+BOOST_AUTO_TEST_CASE(testConcurrentAnnotations)
+{
+  const long lots = 100;
+  std::vector<std::vector<commodity_t *> >
+    seen(thread_count, std::vector<commodity_t *>(lots, NULL));
+
+  BOOST_CHECK_EQUAL(0U, run_concurrently([&seen, lots](std::size_t t) {
+        std::size_t failures = 0;
+        for (long n = 0; n < lots; n++) {
+          long i = (n + static_cast<long>(t) * 31) % lots;
+
+          std::ostringstream buf;
+          buf << "10 AAPL {$" << i + 1 << ".00}";
+          amount_t lot(buf.str());
+
+          commodity_t * comm = &lot.commodity();
+          seen[t][static_cast<std::size_t>(i)] = comm;
+
+          if (! comm->has_annotation() ||
+              &comm->strip_annotations(keep_details_t()) !=
+              &comm->referent() ||
+              &comm->strip_annotations(keep_details_t(true)) != comm ||
+              lot.number() != amount_t(10L))
+            failures++;
+        }
+        return failures;
+      }));
+
+  // Every thread must have been handed the same commodity for each lot.
+  for (std::size_t i = 0; i < static_cast<std::size_t>(lots); i++) {
+    BOOST_CHECK(seen[0][i] != NULL);
+    for (std::size_t t = 1; t < thread_count; t++)
+      BOOST_CHECK_EQUAL(seen[0][i], seen[t][i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testConcurrentPriceHistory)
+{
+  std::vector<datetime_t> moments;
+  moments.push_back(parse_datetime("2005/01/17 00:00:00"));
+  moments.push_back(parse_datetime("2006/01/17 00:00:00"));
+  moments.push_back(parse_datetime("2007/01/17 00:00:00"));
+  moments.push_back(parse_datetime("2007/02/27 18:00:00"));
+  moments.push_back(parse_datetime("2007/02/28 06:00:00"));
+  moments.push_back(parse_datetime("2007/02/28 11:59:59"));
+  moments.push_back(parse_datetime("2007/03/01 00:00:00"));
+  moments.push_back(parse_datetime("2007/04/15 13:00:00"));
+
+  amount_t x1("100.10 AAPL");
+  commodity_t& aapl(x1.commodity());
+
+  aapl.add_price(moments[2], amount_t("$10.20"));
+  aapl.add_price(moments[3], amount_t("$13.40"));
+  aapl.add_price(moments[4], amount_t("$18.33"));
+  aapl.add_price(moments[5], amount_t("$18.30"));
+  aapl.add_price(moments[6], amount_t("$19.50"));
+  aapl.add_price(moments[7], amount_t("$21.22"));
+  aapl.add_price(moments[0], amount_t("EUR 23.00"));
+  aapl.add_price(moments[1], amount_t("CAD 25.00"));
+
+  amount_t one_euro("EUR 1.00");
+  commodity_t& euro(one_euro.commodity());
+
+  euro.add_price(moments[3], amount_t("CAD 1.40"));
+  euro.add_price(moments[0], amount_t("$0.78"));
+
+  // More moments than the price memo holds, so that it keeps turning
+  // over while the threads look prices up.
+  for (int day = 1; day <= 20; day++)
+    moments.push_back(moments[7] + gregorian::days(day));
+
+  std::vector<string> expected;
+  for (std::size_t i = 0; i < moments.size(); i++) {
+    optional<amount_t> value(x1.value(moments[i]));
+    optional<amount_t> in_euro(x1.value(moments[i], &euro));
+    expected.push_back((value ? value->to_string() : string("none")) + ' ' +
+                       (in_euro ? in_euro->to_string() : string("none")));
+  }
+
+  BOOST_CHECK_EQUAL(0U, run_concurrently([&](std::size_t t) {
+        std::size_t failures = 0;
+        for (long n = 0; n < iterations; n++) {
+          // One thread keeps adding prices for an unrelated commodity,
+          // which grows the price graph while the others search it.
+          if (t == 0) {
+            std::ostringstream buf;
+            buf << "JPY " << n + 1;
+            amount_t("1.00 XTS").commodity().add_price
+              (moments[0] + gregorian::days(n), amount_t(buf.str()));
+          }
+
+          std::size_t i = static_cast<std::size_t>(n + static_cast<long>(t))
+            % moments.size();
+          optional<amount_t> value(x1.value(moments[i]));
+          optional<amount_t> in_euro(x1.value(moments[i], &euro));
+          if ((value ? value->to_string() : string("none")) + ' ' +
+              (in_euro ? in_euro->to_string() : string("none")) !=
+              expected[i])
+            failures++;
+        }
+        return failures;
+      }));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
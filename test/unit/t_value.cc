@@ -711,5 +711,34 @@ BOOST_AUTO_TEST_CASE(testNegation)
   BOOST_CHECK(v15.valid());
 }
 
+BOOST_AUTO_TEST_CASE(testStorageReuse)
+{
+  date_t      today(parse_date("2014/08/14"));
+  amount_t    dollar("$1.00");
+  std::size_t allocated = 0;
+
+  // After the first pass has filled the free list, evaluating scalar
+  // expressions should not need to allocate any more storage.
+  for (long i = 0; i < 1000; i++) {
+    if (i == 1)
+      allocated = value_t::storage_t::heap_allocations;
+
+    value_t v1(i);
+    value_t v2(today);
+    value_t v3(dollar);
+    value_t v4(v1 + 1L);
+    value_t v5(v4 > v1);
+
+    v3 += dollar;
+    v3 *= v1;
+
+    BOOST_CHECK(v5.is_boolean());
+    BOOST_CHECK(v2 == value_t(today));
+    BOOST_CHECK_EQUAL(v4, value_t(i + 1));
+  }
+
+  BOOST_CHECK_EQUAL(value_t::storage_t::heap_allocations, allocated);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -0,0 +1,274 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# Time the stages of ledger against reproducible, seeded journals and write
+# the results as JSON, so that they can be compared across commits.
+#
+#   tools/benchmark.py --ledger ./ledger --sizes 10k,100k --output bench.json
+#
+# Parse and finalize times come from ledger's own --verbose timers; every
+# report stage is the "Finished executing command" time of one run, and the
+# best of --repeat runs is kept.  Journals are cached in --workdir and are
+# only regenerated when their profile or seed changes.
+
+from __future__ import print_function, unicode_literals
+
+import os
+import re
+import sys
+import json
+import time
+import random
+import datetime
+import hashlib
+import argparse
+import platform
+import subprocess
+
+# name, postings, accounts, commodities
+PROFILES = [
+  ('10k',      10000,   100,   1),
+  ('100k',    100000,  1000,  10),
+  ('1m',     1000000,  5000,  50),
+  ('10m',   10000000, 20000, 200),
+]
+
+STAGES = [
+  ('reg',           ['reg']),
+  ('bal',           ['bal']),
+  ('bal-V-monthly', ['bal', '-V', '--monthly']),
+  ('csv',           ['csv']),
+  ('print',         ['print']),
+]
+
+TIMER_RE = re.compile(r'\[INFO\]\s+(.+?) \((\d+)ms\)\s*$')
+
+TIMERS = {
+  'Read journal file':          'parse',
+  'Finalized transactions':     'finalize',
+  'Finished executing command': 'command',
+}
+
+class Benchmark:
+  def __init__(self, args):
+    self.ledger  = os.path.abspath(args.ledger)
+    self.workdir = os.path.abspath(args.workdir)
+    self.sizes   = args.sizes.split(',')
+    self.seed    = args.seed
+    self.repeat  = args.repeat
+    self.source  = args.source
+    self.verbose = args.verbose
+
+    if not os.path.isdir(self.workdir):
+      os.makedirs(self.workdir)
+
+  def log(self, msg):
+    if self.verbose:
+      print(msg, file=sys.stderr)
+
+  def journal_path(self, name):
+    return os.path.join(self.workdir, 'bench-%s-%s-%d.dat' %
+                        (self.source, name, self.seed))
+
+  def write_synthetic(self, out, posts, accounts, commodities):
+    rnd = random.Random(self.seed)
+
+    # Commodity symbols may not contain digits unless quoted.
+    symbols = ['$'] + ['C' + ''.join(chr(ord('A') + (i // 26 ** k) % 26)
+                                     for k in (2, 1, 0))
+                       for i in range(1, commodities)]
+    names = set()
+    while len(names) < accounts:
+      depth = rnd.randint(2, 5)
+      top = rnd.choice(['Assets', 'Liabilities', 'Expenses', 'Income'])
+      names.add(':'.join([top] + ['A%d' % rnd.randint(0, accounts // 10 + 5)
+                                  for _ in range(depth - 1)]))
+    names = sorted(names)
+    payees = ['Payee %d' % i for i in range(500)]
+
+    first = datetime.date(2000, 1, 1)
+    days = max(1, min(posts // 20, 365 * 30))
+    prices = dict((sym, 1.0 + rnd.random() * 99.0) for sym in symbols[1:])
+
+    written = 0
+    next_prices = 0
+    while written < posts:
+      date = (first + datetime.timedelta(written * days // posts)) \
+        .strftime('%Y/%m/%d')
+
+      # A hundred rounds of price history, whatever the journal size.
+      if symbols[1:] and written >= next_prices:
+        for sym in symbols[1:]:
+          prices[sym] *= 0.95 + rnd.random() * 0.1
+          out.write('P %s %s $%.2f\n' % (date, sym, prices[sym]))
+        out.write('\n')
+        next_prices += max(1, posts // 100)
+
+      state = rnd.choice(['', '* ', '! '])
+      out.write('%s %s%s\n' % (date, state, rnd.choice(payees)))
+      if rnd.randint(0, 9) == 0:
+        out.write('    ; :tag%d:\n' % rnd.randint(0, 9))
+
+      # Each transaction moves a single commodity.  Costs are left out on
+      # purpose: every distinct cost starts a new lot, and lots would make
+      # the running totals grow with the journal rather than its shape.
+      sym = rnd.choice(symbols)
+      count = rnd.randint(1, 3)
+      for _ in range(count):
+        account = rnd.choice(names)
+        if sym == '$':
+          out.write('    %-40s  $%d.%02d\n' %
+                    (account, rnd.randint(1, 5000), rnd.randint(0, 99)))
+        else:
+          out.write('    %-40s  %d %s\n' %
+                    (account, rnd.randint(1, 100), sym))
+      out.write('    %s\n\n' % rnd.choice(names))
+      written += count + 1
+
+    return written
+
+  def write_generated(self, out, posts):
+    # The generate command averages about five postings per transaction.
+    proc = subprocess.Popen([self.ledger, '--args-only',
+                             '--seed=%d' % self.seed,
+                             '--head=%d' % max(1, posts // 5), 'generate'],
+                            stdout=out)
+    if proc.wait() != 0:
+      raise RuntimeError('ledger generate failed for seed %d' % self.seed)
+
+  def prepare(self, name, posts, accounts, commodities):
+    path = self.journal_path(name)
+    if not os.path.exists(path):
+      self.log('Writing %s' % path)
+      with open(path + '.tmp', 'w') as out:
+        if self.source == 'generate':
+          self.write_generated(out, posts)
+        else:
+          self.write_synthetic(out, posts, accounts, commodities)
+      os.rename(path + '.tmp', path)
+
+    digest = hashlib.sha1()
+    with open(path, 'rb') as data:
+      for block in iter(lambda: data.read(1 << 20), b''):
+        digest.update(block)
+    return path, digest.hexdigest()
+
+  def run(self, path, command):
+    args = [self.ledger, '--args-only', '--verbose', '--columns=80',
+            '-f', path] + command
+    start = time.time()
+    proc = subprocess.Popen(args, stdout=open(os.devnull, 'w'),
+                            stderr=subprocess.PIPE)
+    _, err = proc.communicate()
+    wall = (time.time() - start) * 1000.0
+    if proc.returncode != 0:
+      raise RuntimeError('%s failed:\n%s' %
+                         (' '.join(args),
+                          err.decode('utf-8', 'replace')[-2000:]))
+
+    timers = {'wall': int(round(wall))}
+    for line in err.decode('utf-8', 'replace').splitlines():
+      match = TIMER_RE.search(line)
+      if match and match.group(1) in TIMERS:
+        timers[TIMERS[match.group(1)]] = int(match.group(2))
+    return timers
+
+  def measure(self, name, posts, accounts, commodities):
+    path, sha1 = self.prepare(name, posts, accounts, commodities)
+
+    stages = dict()
+    wall = dict()
+    for stage, command in STAGES:
+      for _ in range(self.repeat):
+        self.log('Running %s on %s' % (stage, name))
+        timers = self.run(path, command)
+        # Every run parses the journal again, so the parse and finalize
+        # stages take the best time seen across all report runs.
+        for key in ('parse', 'finalize'):
+          if key in timers:
+            stages[key] = min(stages.get(key, timers[key]), timers[key])
+        if 'command' in timers:
+          stages[stage] = min(stages.get(stage, timers['command']),
+                              timers['command'])
+        wall[stage] = min(wall.get(stage, timers['wall']), timers['wall'])
+
+    return {
+      'profile':     name,
+      'source':      self.source,
+      'seed':        self.seed,
+      'posts':       posts,
+      'accounts':    accounts if self.source == 'synthetic' else None,
+      'commodities': commodities if self.source == 'synthetic' else None,
+      'journal':     {'bytes': os.path.getsize(path), 'sha1': sha1},
+      'stages_ms':   stages,
+      'wall_ms':     wall,
+    }
+
+  def version(self):
+    out = subprocess.check_output([self.ledger, '--args-only', '--version'])
+    return out.decode('utf-8', 'replace').splitlines()[0]
+
+  def commit(self):
+    try:
+      out = subprocess.check_output(
+        ['git', 'describe', '--always', '--dirty'],
+        cwd=os.path.dirname(os.path.realpath(__file__)),
+        stderr=open(os.devnull, 'w'))
+      return out.decode('utf-8').strip()
+    except (OSError, subprocess.CalledProcessError):
+      return None
+
+  def main(self):
+    profiles = dict((p[0], p) for p in PROFILES)
+    results = list()
+    for size in self.sizes:
+      if size not in profiles:
+        raise RuntimeError('Unknown size %s (expected one of %s)' %
+                           (size, ', '.join(p[0] for p in PROFILES)))
+      results.append(self.measure(*profiles[size]))
+
+    return {
+      'ledger':    self.ledger,
+      'version':   self.version(),
+      'commit':    self.commit(),
+      'host':      platform.node(),
+      'platform':  platform.platform(),
+      'timestamp': time.strftime('%Y-%m-%dT%H:%M:%SZ', time.gmtime()),
+      'repeat':    self.repeat,
+      'results':   results,
+    }
+
+if __name__ == '__main__':
+  parser = argparse.ArgumentParser(
+    description='Time ledger stages on seeded journals and report JSON')
+  parser.add_argument('-l', '--ledger', type=str, required=True,
+                      help='the path to the ledger executable to benchmark')
+  parser.add_argument('-w', '--workdir', type=str, default='benchmark',
+                      help='directory in which generated journals are cached')
+  parser.add_argument('-s', '--sizes', type=str, default='10k,100k',
+                      help='comma separated profiles to run: ' +
+                      ', '.join(p[0] for p in PROFILES))
+  parser.add_argument('--seed', type=int, default=1,
+                      help='random seed used to generate the journals')
+  parser.add_argument('-r', '--repeat', type=int, default=3,
+                      help='runs per stage; the fastest one is reported')
+  parser.add_argument('--source', choices=['synthetic', 'generate'],
+                      default='synthetic',
+                      help='write journals with fixed account and commodity '
+                      'counts, or with ledger\'s own generate command (whose '
+                      'random lots make reports costly beyond a few thousand '
+                      'transactions)')
+  parser.add_argument('-o', '--output', type=str,
+                      help='write the JSON report here instead of stdout')
+  parser.add_argument('-v', '--verbose', action='store_true',
+                      help='report progress on stderr')
+  args = parser.parse_args()
+
+  report = Benchmark(args).main()
+  if args.output:
+    with open(args.output, 'w') as out:
+      json.dump(report, out, indent=2, sort_keys=True)
+      out.write('\n')
+  else:
+    json.dump(report, sys.stdout, indent=2, sort_keys=True)
+    sys.stdout.write('\n')